@@ -3,9 +3,31 @@
 # has been requested, issue a warning indicating the tests will not exercise
 # the coroutine integration in the stlab library.
 #
-# As of writing, no version of the GNU C++ compiler supports the coroutines TS.
+# The GNU C++ compiler supports the C++20 coroutines as of version 10.
 #
-if( CMAKE_CXX_COMPILER_ID STREQUAL "GNU" AND stlab.coroutines )
+if( CMAKE_CXX_COMPILER_ID STREQUAL "GNU"
+    AND CMAKE_CXX_COMPILER_VERSION VERSION_LESS 10.0
+    AND stlab.coroutines )
   message( WARNING "${CMAKE_CXX_COMPILER_ID}-${CMAKE_CXX_COMPILER_VERSION} does not support coroutines." )
   message( STATUS "Coroutines will not be used in testing" )
 endif()
+
+#
+# If the `COROUTINE` property has been established on the target and set
+# to `ON` and the GNU compiler version is sufficient to support C++20
+# coroutines, return 1.
+#
+# Otherwise return 0.
+#
+string( CONCAT gnu_active
+  "$<AND:$<CXX_COMPILER_ID:GNU>"
+       ",$<BOOL:$<TARGET_PROPERTY:COROUTINES>>"
+       ",$<NOT:$<VERSION_LESS:$<CXX_COMPILER_VERSION>,10>>>" )
+
+#
+# If using GNU and active, compile as C++20 with the coroutines flag and set
+# a preprocessor definition to enable the use of coroutines in the headers.
+#
+target_compile_features( coroutines INTERFACE $<${gnu_active}:cxx_std_20> )
+target_compile_options( coroutines INTERFACE $<${gnu_active}:-fcoroutines> )
+target_compile_definitions( coroutines INTERFACE $<${gnu_active}:STLAB_FUTURE_COROUTINES=1> )
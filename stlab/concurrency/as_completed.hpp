@@ -0,0 +1,196 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#ifndef STLAB_CONCURRENCY_AS_COMPLETED_HPP
+#define STLAB_CONCURRENCY_AS_COMPLETED_HPP
+
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <stlab/concurrency/channel.hpp>
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+
+#include <stlab/memory.hpp>
+
+/**************************************************************************************************/
+
+namespace stlab {
+
+/**************************************************************************************************/
+
+inline namespace v1 {
+
+/**************************************************************************************************/
+
+namespace detail {
+
+/**************************************************************************************************/
+
+/*
+    Owns the futures that did not complete yet and sends the fulfilled ones one at a time. The next
+    value or error is only sent when the channel has room for it, the others wait in their futures.
+    The context is owned by the process of the channel, so dropping the receiver releases all
+    pending futures. The channel is closed after the last future completed and was sent.
+*/
+template <typename T>
+class as_completed_context : public std::enable_shared_from_this<as_completed_context<T>> {
+    std::mutex _mutex;
+    sender<T> _send;
+    std::vector<future<T>> _holds;
+    std::deque<future<T>> _ready;
+    future<void> _sending;
+    std::size_t _sends{0};
+    std::size_t _remaining{0};
+    bool _forwarding{false};
+
+    void forward() {
+        while (true) {
+            future<T> x;
+            bool done = false;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                if (_ready.empty()) {
+                    _forwarding = false;
+                    done = _remaining == 0;
+                } else {
+                    x = std::move(_ready.front());
+                    _ready.pop_front();
+                }
+            }
+
+            if (!x.valid()) {
+                if (done) _send.close();
+                return;
+            }
+
+            auto ex = x.exception();
+            auto sent = ex ? _send.async_send(std::move(ex)) :
+                             _send.async_send(std::move(*std::move(x).get_try()));
+            if (!sent.is_ready()) {
+                std::size_t send;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    send = ++_sends;
+                }
+                auto pending = std::move(sent).recover(
+                    immediate_executor, [_w = make_weak_ptr(this->shared_from_this())](auto&&) {
+                        if (auto p = _w.lock()) p->forward();
+                    });
+                // The continuation may already have run and started a newer send
+                std::unique_lock<std::mutex> lock(_mutex);
+                if (send == _sends) _sending = std::move(pending);
+                return;
+            }
+        }
+    }
+
+    void completed(std::size_t index, future<T> x) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _holds[index].reset();
+            _ready.push_back(std::move(x));
+            --_remaining;
+            if (_forwarding) return;
+            _forwarding = true;
+        }
+        forward();
+    }
+
+public:
+    template <typename I>
+    void start(sender<T> send, I first, I last) {
+        _send = std::move(send);
+
+        // All futures must be owned by the context before the first continuation may run
+        _holds.assign(first, last);
+        _remaining = _holds.size();
+        for (std::size_t index = 0, size = _holds.size(); index != size; ++index) {
+            attach_continuation(_holds[index], immediate_executor,
+                                [_w = make_weak_ptr(this->shared_from_this()), index](auto x) {
+                                    if (auto p = _w.lock()) p->completed(index, std::move(x));
+                                });
+        }
+
+        // Closes the channel at once if the range was empty
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_forwarding) return;
+            _forwarding = true;
+        }
+        forward();
+    }
+};
+
+/*
+    Passes the values on unchanged and keeps the context alive as long as the channel.
+*/
+template <typename T>
+struct as_completed_process {
+    std::shared_ptr<as_completed_context<T>> _context;
+
+    template <typename U>
+    U operator()(U&& x) const {
+        return std::forward<U>(x);
+    }
+};
+
+/**************************************************************************************************/
+
+} // namespace detail
+
+/**************************************************************************************************/
+
+/*
+ * as_completed returns a receiver that emits the value of each future of the given range as soon
+ * as it is fulfilled, so downstream processes can start without waiting for the slowest future.
+ * A failed future is passed on as error. The channel is closed after the last future completed.
+ *
+ * The futures are copied, like by when_all(), so the range stays valid. Futures of move only
+ * values can not be copied, pass them with std::make_move_iterator(). Dropping the receiver
+ * releases the futures that did not complete yet, so the ones that were moved in get cancelled.
+ *
+ * The returned receiver buffers a single value. A value or error that is fulfilled while the
+ * downstream processes are full stays in its future until a downstream process has room, so a
+ * buffer_size on a downstream process bounds the values and errors that are in flight.
+ */
+template <
+    typename E, // models task executor
+    typename I> // models ForwardIterator that reference to a range of futures of the same type
+auto as_completed(E executor, std::pair<I, I> range) {
+    using value_t = typename std::iterator_traits<I>::value_type::result_type;
+    static_assert(!std::is_same<value_t, void>::value,
+                  "as_completed requires futures with a result type");
+
+    auto context = std::make_shared<detail::as_completed_context<value_t>>();
+    auto channel = detail::channel_<E, value_t>::create(
+        std::move(executor), detail::as_completed_process<value_t>{context});
+
+    context->start(std::move(channel.first), range.first, range.second);
+
+    return std::move(channel.second);
+}
+
+/**************************************************************************************************/
+
+} // namespace v1
+
+/**************************************************************************************************/
+
+} // namespace stlab
+
+/**************************************************************************************************/
+
+#endif // STLAB_CONCURRENCY_AS_COMPLETED_HPP
+
+/**************************************************************************************************/
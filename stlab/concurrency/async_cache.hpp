@@ -0,0 +1,207 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#ifndef STLAB_CONCURRENCY_ASYNC_CACHE_HPP
+#define STLAB_CONCURRENCY_ASYNC_CACHE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include <stlab/concurrency/future.hpp>
+
+/**************************************************************************************************/
+
+namespace stlab {
+
+/**************************************************************************************************/
+
+inline namespace v1 {
+
+/**************************************************************************************************/
+
+struct async_cache_statistics {
+    std::size_t _hits;      // the value was already available
+    std::size_t _misses;    // a new load was started
+    std::size_t _coalesced; // joined a load that is still in flight
+    std::size_t _evictions; // removed because the capacity was exceeded
+};
+
+/**************************************************************************************************/
+
+/*
+ * async_cache coalesces concurrent requests of the same key onto one load and keeps the resulting
+ * futures, so all callers share one computation. Entries are evicted in least recently used order
+ * when a shard exceeds its capacity and are reloaded when their load completed longer than the
+ * time to live ago. Entries whose load is still in flight are not evicted, so a shard may exceed
+ * its capacity while its loads are running. Failed loads are not cached. The keys are distributed
+ * over independently locked shards.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class async_cache {
+    static_assert(std::is_copy_constructible<V>::value,
+                  "async_cache shares its futures and so requires a copyable value type");
+
+    using clock_t = std::chrono::steady_clock;
+    using lru_t = std::list<K>;
+
+    using loaded_t = std::atomic<clock_t::rep>;
+
+    struct entry {
+        future<V> _value;
+        std::shared_ptr<loaded_t> _loaded; // time since epoch of the completion of the load
+        typename lru_t::iterator _lru;
+    };
+
+    struct shard {
+        std::mutex _mutex;
+        std::unordered_map<K, entry, Hash> _entries;
+        lru_t _lru; // most recently used first
+    };
+
+    Hash _hash;
+    std::size_t _shard_count;
+    std::size_t _shard_capacity;
+    std::chrono::nanoseconds _ttl;
+    std::unique_ptr<shard[]> _shards;
+
+    std::atomic_size_t _hits{0};
+    std::atomic_size_t _misses{0};
+    std::atomic_size_t _coalesced{0};
+    std::atomic_size_t _evictions{0};
+
+    shard& shard_of(const K& key) { return _shards[_hash(key) % _shard_count]; }
+
+    clock_t::time_point expiration(clock_t::time_point now) const {
+        if (_ttl >= clock_t::time_point::max() - now) return clock_t::time_point::max();
+        return now + std::chrono::duration_cast<clock_t::duration>(_ttl);
+    }
+
+    // The time to live starts when the load completes, so a slow load does not use it up
+    bool usable(const entry& e, clock_t::time_point now) const {
+        if (!e._value.is_ready()) return true;
+        if (e._value.exception()) return false;
+        return expiration(clock_t::time_point(clock_t::duration(e._loaded->load()))) > now;
+    }
+
+    // Entries whose load is in flight are skipped, so that further requests still join the load
+    void evict(shard& s) {
+        auto i = s._lru.end();
+        while (s._entries.size() > _shard_capacity && i != s._lru.begin()) {
+            --i;
+            auto found = s._entries.find(*i);
+            if (!found->second._value.is_ready()) continue;
+            s._entries.erase(found);
+            i = s._lru.erase(i);
+            ++_evictions;
+        }
+    }
+
+public:
+    explicit async_cache(std::size_t capacity,
+                         std::chrono::nanoseconds ttl = std::chrono::nanoseconds::max(),
+                         std::size_t shards = std::max(1u, std::thread::hardware_concurrency()),
+                         Hash hash = Hash()) :
+        _hash(std::move(hash)), _shard_count(std::max<std::size_t>(1, std::min(shards, capacity))),
+        _shard_capacity(std::max<std::size_t>(1, (capacity + _shard_count - 1) / _shard_count)),
+        _ttl(ttl), _shards(new shard[_shard_count]) {
+        assert(capacity > 0);
+    }
+
+    async_cache(const async_cache&) = delete;
+    async_cache& operator=(const async_cache&) = delete;
+
+    /*
+     * Returns the future of key. If there is none, load(key) is scheduled on executor.
+     */
+    template <typename E, typename F>
+    future<V> get(E executor, F&& load, const K& key) {
+        auto& s = shard_of(key);
+        const auto now = clock_t::now();
+
+        std::pair<packaged_task<>, future<V>> p;
+        {
+            std::unique_lock<std::mutex> lock(s._mutex);
+            auto found = s._entries.find(key);
+            if (found != s._entries.end()) {
+                auto& e = found->second;
+                if (usable(e, now)) {
+                    s._lru.splice(s._lru.begin(), s._lru, e._lru);
+                    if (e._value.is_ready())
+                        ++_hits;
+                    else
+                        ++_coalesced;
+                    return e._value;
+                }
+                s._lru.erase(e._lru);
+                s._entries.erase(found);
+            }
+
+            ++_misses;
+            auto loaded = std::make_shared<loaded_t>(0);
+            p = package<V()>(executor, [_load = std::forward<F>(load), _key = key,
+                                        _loaded = loaded]() mutable {
+                auto result = _load(_key);
+                *_loaded = clock_t::now().time_since_epoch().count();
+                return result;
+            });
+            s._lru.push_front(key);
+            s._entries.emplace(key, entry{p.second, std::move(loaded), s._lru.begin()});
+            evict(s);
+        }
+
+        // The load is scheduled without holding the lock, so it may access the cache itself
+        executor(std::move(p.first));
+        return std::move(p.second);
+    }
+
+    void erase(const K& key) {
+        auto& s = shard_of(key);
+        std::unique_lock<std::mutex> lock(s._mutex);
+        auto found = s._entries.find(key);
+        if (found == s._entries.end()) return;
+        s._lru.erase(found->second._lru);
+        s._entries.erase(found);
+    }
+
+    std::size_t size() const {
+        std::size_t result = 0;
+        for (std::size_t i = 0; i != _shard_count; ++i) {
+            std::unique_lock<std::mutex> lock(_shards[i]._mutex);
+            result += _shards[i]._entries.size();
+        }
+        return result;
+    }
+
+    async_cache_statistics statistics() const {
+        return {_hits.load(), _misses.load(), _coalesced.load(), _evictions.load()};
+    }
+};
+
+/**************************************************************************************************/
+
+} // namespace v1
+
+/**************************************************************************************************/
+
+} // namespace stlab
+
+/**************************************************************************************************/
+
+#endif // STLAB_CONCURRENCY_ASYNC_CACHE_HPP
+
+/**************************************************************************************************/
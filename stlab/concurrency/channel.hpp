@@ -15,17 +15,25 @@
 #include <cassert>
 #include <chrono>
 #include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <numeric>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include <stlab/concurrency/executor_base.hpp>
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
 #include <stlab/concurrency/optional.hpp>
 #include <stlab/concurrency/traits.hpp>
 #include <stlab/concurrency/tuple_algorithm.hpp>
+#include <stlab/concurrency/utility.hpp>
 #include <stlab/concurrency/variant.hpp>
+#include <stlab/copy_on_write.hpp>
 #include <stlab/functional.hpp>
 #include <stlab/memory.hpp>
 
@@ -283,11 +291,20 @@ struct shared_process_sender {
 
     virtual void send(avoid<T> x) = 0;
     virtual void send(std::exception_ptr) = 0;
+    virtual future<void> async_send(avoid<T> x) = 0;
+    virtual future<void> async_send(std::exception_ptr) = 0;
     virtual void add_sender() = 0;
     virtual void remove_sender() = 0;
     virtual std::size_t free_buffer() const = 0;
 };
 
+inline future<void> broken_channel_future() {
+    auto p = package<void()>(immediate_executor,
+                             [] { throw channel_error(channel_error_codes::broken_channel); });
+    p.first();
+    return std::move(p.second);
+}
+
 /**************************************************************************************************/
 
 template <typename T>
@@ -306,6 +323,27 @@ template <typename T>
 auto process_close(stlab::optional<T>&)
     -> std::enable_if_t<!has_process_close_v<unwrap_reference_t<T>>> {}
 
+/*
+    A process may provide end_of_input(). Other than close(), which is called each time the queue
+    runs empty, it is called once, after all senders are gone and the queued values were processed.
+    A process that keeps partial state until the end of its input can yield it from there on.
+*/
+template <typename T>
+using process_end_of_input_t = decltype(std::declval<T&>().end_of_input());
+
+template <typename T>
+constexpr bool has_process_end_of_input_v = is_detected_v<process_end_of_input_t, T>;
+
+template <typename T>
+auto process_end_of_input(stlab::optional<T>& x)
+    -> std::enable_if_t<has_process_end_of_input_v<unwrap_reference_t<T>>> {
+    if (x) unwrap(*x).end_of_input();
+}
+
+template <typename T>
+auto process_end_of_input(stlab::optional<T>&)
+    -> std::enable_if_t<!has_process_end_of_input_v<unwrap_reference_t<T>>> {}
+
 /**************************************************************************************************/
 
 template <typename T>
@@ -361,6 +399,28 @@ using process_await_t = decltype(std::declval<T&>().await(std::declval<Args>()..
 template <typename T, typename... Args>
 constexpr bool has_process_await_v = is_detected_v<process_await_t, T, Args...>;
 
+/*
+ * A process with await_batch(std::vector<T>&) instead of await(T) receives all values that are
+ * queued, up to its buffer size, in one call. It may move the values out of the vector, which is
+ * reused for the next batch. Otherwise it has yield() and state() as any other process and may
+ * yield zero or more values after a batch. An error is passed to set_error() after the values
+ * that were sent before it.
+ */
+template <typename T, typename U>
+using process_await_batch_t =
+    decltype(std::declval<T&>().await_batch(std::declval<std::vector<U>&>()));
+
+template <typename T, typename U>
+constexpr bool has_process_await_batch_v = is_detected_v<process_await_batch_t, T, U>;
+
+template <typename U>
+struct batch_buffer {
+    std::vector<U> _values;
+    std::exception_ptr _error;
+};
+
+struct no_batch_buffer {};
+
 /**************************************************************************************************/
 
 template <typename P, typename... T, std::size_t... I>
@@ -425,6 +485,180 @@ struct default_queue_strategy {
 
 /**************************************************************************************************/
 
+/*
+ * A bounded lock free ring buffer with many producers and a single consumer. Each cell carries a
+ * sequence number that tells whether it is free for the producer of position pos (2 * pos) or
+ * holds the value of position pos (2 * pos + 1). The factor keeps the two apart for a capacity of
+ * one. The consumer side must be serialized by the caller.
+ */
+template <typename T>
+class mpsc_ring {
+    struct cell {
+        std::atomic_size_t _sequence;
+        stlab::optional<T> _value;
+    };
+
+    std::unique_ptr<cell[]> _cells;
+    const std::size_t _capacity;
+    alignas(64) std::atomic_size_t _tail{0};
+    alignas(64) std::size_t _head{0};
+
+public:
+    explicit mpsc_ring(std::size_t capacity) : _cells(new cell[capacity]), _capacity(capacity) {
+        assert(capacity > 0 && "mpsc_ring: capacity must not be zero");
+        for (std::size_t i = 0; i != capacity; ++i)
+            _cells[i]._sequence.store(2 * i, std::memory_order_relaxed);
+    }
+
+    std::size_t capacity() const { return _capacity; }
+
+    // Returns false and leaves x untouched if the ring is full
+    template <typename U>
+    bool try_push(U&& x) {
+        auto pos = _tail.load(std::memory_order_relaxed);
+        while (true) {
+            auto& c = _cells[pos % _capacity];
+            const auto sequence = c._sequence.load(std::memory_order_acquire);
+            const auto distance = static_cast<std::ptrdiff_t>(sequence - 2 * pos);
+            if (distance == 0) {
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c._value = std::forward<U>(x);
+                    // Sequentially consistent, so that it is ordered with the running flag of the
+                    // process
+                    c._sequence.store(2 * pos + 1);
+                    return true;
+                }
+            } else if (distance < 0) {
+                return false;
+            } else {
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    stlab::optional<T> try_pop() {
+        auto& c = _cells[_head % _capacity];
+        if (c._sequence.load() != 2 * _head + 1) return nullopt;
+        stlab::optional<T> result = std::move(c._value);
+        c._value = nullopt;
+        c._sequence.store(2 * (_head + _capacity), std::memory_order_release);
+        ++_head;
+        return result;
+    }
+
+    bool empty() const { return _cells[_head % _capacity]._sequence.load() != 2 * _head + 1; }
+
+    // The number of claimed cells, including those that a producer is still writing
+    std::size_t size() const { return _tail.load() - _head; }
+};
+
+/*
+ * mpsc_queue_strategy lets senders append to a lock free ring without the process mutex. The ring
+ * holds as many values as the buffer size of the process, for a buffer size of 0, which means
+ * unbounded, it holds unbounded_capacity values. Values that do not fit go to an overflow queue
+ * under the mutex, as with the default queue, and until it is drained all senders use it, so the
+ * values of each sender stay in order. The overflow queue has no limit, so as with the default
+ * queue the buffer size does not bound memory; it bounds only the lock free part, and senders that
+ * outrun the process still grow the queue.
+ *
+ * A new buffer size routes all senders to the overflow queue until the ring is drained and no
+ * sender is writing to it anymore, then the ring is replaced. All members except the ring's
+ * producer side are guarded by the process mutex.
+ */
+template <typename T>
+struct mpsc_queue_strategy {
+    static const std::size_t arguments_size = 1;
+    static const std::size_t unbounded_capacity = 1024;
+    using item_t = variant<avoid<T>, std::exception_ptr>;
+    using value_type = std::tuple<item_t>;
+
+    std::unique_ptr<mpsc_ring<item_t>> _ring{std::make_unique<mpsc_ring<item_t>>(1)};
+    std::deque<item_t> _overflow;
+    std::atomic_bool _overflowing{false};
+    std::atomic_size_t _writers{0};
+    std::size_t _capacity{1};
+    bool _resizing{false};
+    stlab::optional<item_t> _front;
+
+    void update() {
+        if (_resizing && _writers == 0 && _ring->size() == 0) {
+            _ring = std::make_unique<mpsc_ring<item_t>>(_capacity);
+            _resizing = false;
+        }
+        if (!_resizing && _overflow.empty()) _overflowing = false;
+    }
+
+    // The overflow is only used once no cell of the ring is claimed anymore, so it does not pass
+    // ring values behind a cell that a sender is still writing
+    bool empty() const {
+        return !_front && _ring->empty() && (_ring->size() != 0 || _overflow.empty());
+    }
+
+    // front() takes the value out of the queue, pop_front() releases it
+    auto front() {
+        if (!_front) {
+            _front = _ring->try_pop();
+            if (!_front) {
+                _front = std::move(_overflow.front());
+                _overflow.pop_front();
+            }
+        }
+        return std::make_tuple(std::move(*_front));
+    }
+
+    void pop_front() {
+        _front = nullopt;
+        update();
+    }
+
+    auto size() const { return std::array<std::size_t, 1>{{queue_size<0>()}}; }
+
+    template <std::size_t>
+    std::size_t queue_size() const {
+        return _ring->size() + _overflow.size();
+    }
+
+    void set_capacity(std::size_t buffer_size) {
+        const auto capacity = buffer_size == 0 ? unbounded_capacity : buffer_size;
+        if (capacity == _capacity) return;
+        _capacity = capacity;
+        _resizing = true;
+        // Sequentially consistent with the check of the writers in update()
+        _overflowing = true;
+        update();
+    }
+
+    // Called without the process mutex, returns false if u must be appended under the mutex
+    template <std::size_t, typename U>
+    bool try_append(U&& u) {
+        ++_writers;
+        const bool result = !_overflowing && _ring->try_push(std::forward<U>(u));
+        --_writers;
+        return result;
+    }
+
+    template <std::size_t, typename U>
+    void append(U&& u) {
+        if (!_overflowing && _ring->try_push(std::forward<U>(u))) return;
+        _overflow.emplace_back(std::forward<U>(u));
+        _overflowing = true;
+    }
+};
+
+template <typename Q, typename U>
+using queue_try_append_t = decltype(std::declval<Q&>().template try_append<0>(std::declval<U>()));
+
+template <typename Q, typename U>
+constexpr bool has_queue_try_append_v = is_detected_v<queue_try_append_t, Q, U>;
+
+template <typename Q>
+using queue_set_capacity_t = decltype(std::declval<Q&>().set_capacity(std::size_t()));
+
+template <typename Q>
+constexpr bool has_queue_set_capacity_v = is_detected_v<queue_set_capacity_t, Q>;
+
+/**************************************************************************************************/
+
 template <typename... T>
 struct zip_with_queue_strategy {
     static const std::size_t Size = sizeof...(T);
@@ -587,6 +821,17 @@ struct unordered_queue_strategy {
 template <typename Q, typename T, typename R, typename... Args>
 struct shared_process;
 
+// The process that is currently stepping on this thread and whether it asked to run again
+struct step_context {
+    const void* _process{nullptr};
+    bool _again{false};
+};
+
+inline step_context& current_step() {
+    thread_local step_context context;
+    return context;
+}
+
 template <typename Q, typename T, typename R, typename Arg, std::size_t I, typename... Args>
 struct shared_process_sender_indexed : public shared_process_sender<Arg> {
     shared_process<Q, T, R, Args...>& _shared_process;
@@ -612,6 +857,26 @@ struct shared_process_sender_indexed : public shared_process_sender<Arg> {
     template <typename U>
     void enqueue(U&& u) {
         bool do_run;
+        if constexpr (has_queue_try_append_v<Q, U>) {
+            /*
+                The value is appended without the lock. A running process finds it, because
+                task_done() and clear_to_send() clear _process_running before they check the queue
+                for the last time.
+            */
+            if (_shared_process._queue.template try_append<I>(std::forward<U>(u))) {
+                if (_shared_process._process_running && !_shared_process._timeout_function_active)
+                    return;
+                {
+                    std::unique_lock<std::mutex> lock(_shared_process._process_mutex);
+                    do_run = !_shared_process._receiver_count &&
+                             (!_shared_process._process_running ||
+                              _shared_process._timeout_function_active);
+                    _shared_process._process_running = _shared_process._process_running || do_run;
+                }
+                if (do_run) _shared_process.run();
+                return;
+            }
+        }
         {
             std::unique_lock<std::mutex> lock(_shared_process._process_mutex);
             _shared_process._queue.template append<I>(
@@ -628,6 +893,57 @@ struct shared_process_sender_indexed : public shared_process_sender<Arg> {
 
     void send(avoid<Arg> arg) override { enqueue(std::move(arg)); }
 
+    /*
+        Values that do not fit into the buffer wait here, with the task that makes the future of
+        async_send() ready, until the process has taken enough values from the queue. Guarded by
+        the process mutex.
+    */
+    std::vector<std::pair<variant<avoid<Arg>, std::exception_ptr>, packaged_task<>>> _waiting;
+
+    bool within_buffer() const {
+        return _shared_process._process_buffer_size == 0 ||
+               _shared_process._queue.template queue_size<I>() <
+                   _shared_process._process_buffer_size;
+    }
+
+    template <typename U>
+    future<void> async_enqueue(U&& u) {
+        bool do_run;
+        {
+            std::unique_lock<std::mutex> lock(_shared_process._process_mutex);
+            if (!_waiting.empty() || !within_buffer()) {
+                auto p = package<void()>(immediate_executor, [] {});
+                _waiting.emplace_back(std::forward<U>(u), std::move(p.first));
+                return std::move(p.second);
+            }
+            _shared_process._queue.template append<I>(std::forward<U>(u));
+            do_run = !_shared_process._receiver_count && (!_shared_process._process_running ||
+                                                          _shared_process._timeout_function_active);
+            _shared_process._process_running = _shared_process._process_running || do_run;
+        }
+        if (do_run) _shared_process.run();
+
+        auto p = package<void()>(immediate_executor, [] {});
+        p.first();
+        return std::move(p.second);
+    }
+
+    future<void> async_send(std::exception_ptr error) override {
+        return async_enqueue(std::move(error));
+    }
+
+    future<void> async_send(avoid<Arg> arg) override { return async_enqueue(std::move(arg)); }
+
+    // Moves waiting values into the queue while there is room, called with the process mutex held
+    void admit_waiting(std::vector<packaged_task<>>& ready) {
+        auto first = _waiting.begin();
+        for (; first != _waiting.end() && within_buffer(); ++first) {
+            _shared_process._queue.template append<I>(std::move(first->first));
+            ready.push_back(std::move(first->second));
+        }
+        _waiting.erase(_waiting.begin(), first);
+    }
+
     std::size_t free_buffer() const override {
         std::unique_lock<std::mutex> lock(_shared_process._process_mutex);
         return _shared_process._process_buffer_size == 0 ?
@@ -647,6 +963,10 @@ struct shared_process_sender_helper<Q, T, R, std::index_sequence<I...>, Args...>
     : shared_process_sender_indexed<Q, T, R, Args, I, Args...>... {
     shared_process_sender_helper(shared_process<Q, T, R, Args...>& sp) :
         shared_process_sender_indexed<Q, T, R, Args, I, Args...>(sp)... {}
+
+    void admit_waiting(std::vector<packaged_task<>>& ready) {
+        (shared_process_sender_indexed<Q, T, R, Args, I, Args...>::admit_waiting(ready), ...);
+    }
 };
 
 /**************************************************************************************************/
@@ -670,8 +990,11 @@ struct downstream<
     std::size_t size() const { return _data.size(); }
 
     template <typename... Args>
-    void send(std::size_t n, Args... args) {
-        stlab::for_each_n(begin(_data), n, [&](const auto& e) { e(args...); });
+    void send(std::size_t n, Args&&... args) {
+        if (n == 0) return;
+        // Every receiver but the last gets a copy, the last one takes the value
+        auto last = stlab::for_each_n(begin(_data), n - 1, [&](const auto& e) { e(args...); });
+        (*last)(std::forward<Args>(args)...);
     }
 
     std::size_t minimum_free_buffer() const {
@@ -743,7 +1066,8 @@ struct shared_process
 
     std::mutex _process_mutex;
 
-    bool _process_running = false;
+    // Atomic, because senders that append without the lock read it
+    std::atomic_bool _process_running{false};
     std::atomic_size_t _process_suspend_count{0};
     bool _process_close_queue = false;
     // REVISIT (sparent) : I'm not certain final needs to be under the mutex
@@ -751,14 +1075,25 @@ struct shared_process
 
     std::mutex _timeout_function_control;
     std::atomic_bool _timeout_function_active{false};
+    // Each step cancels the timeouts scheduled before, guarded by _timeout_function_control
+    std::size_t _timeout_generation{0};
 
     std::atomic_size_t _sender_count{0};
     std::atomic_size_t _receiver_count;
 
     std::atomic_size_t _process_buffer_size{1};
 
+    // The most messages and time a process may take in one task on the executor
+    std::size_t _quantum_messages{1};
+    std::chrono::nanoseconds _quantum_duration{std::chrono::nanoseconds::max()};
+
     const std::tuple<std::shared_ptr<shared_process_receiver<Args>>...> _upstream;
 
+    using batch_value_t = avoid<first_t<Args...>>;
+    static constexpr bool is_batch_process =
+        has_process_await_batch_v<unwrap_reference_t<T>, batch_value_t>;
+    std::conditional_t<is_batch_process, batch_buffer<batch_value_t>, no_batch_buffer> _batch;
+
 
 
     template <typename E, typename F>
@@ -813,6 +1148,7 @@ struct shared_process
         bool do_final;
         {
             std::unique_lock<std::mutex> lock(_process_mutex);
+            _process_running = false;
             do_run = !_queue.empty() || _process_close_queue;
             _process_running = do_run;
             do_final = _process_final;
@@ -848,7 +1184,9 @@ struct shared_process
                     do_run = true;
                 } else {
                     _process_running = false;
-                    do_run = false;
+                    // A sender may have appended without the lock before the flag was cleared
+                    do_run = !_queue.empty();
+                    _process_running = do_run;
                 }
             }
         }
@@ -861,6 +1199,8 @@ struct shared_process
         std::array<bool, sizeof...(Args)> do_cts = {{false}};
         bool do_close = false;
 
+        std::vector<packaged_task<>> ready;
+
         std::unique_lock<std::mutex> lock(_process_mutex);
         if (_queue.empty()) {
             std::swap(do_close, _process_close_queue);
@@ -868,10 +1208,15 @@ struct shared_process
         } else {
             message = std::move(_queue.front());
             _queue.pop_front();
+            this->admit_waiting(ready);
             auto queue_size = _queue.size();
             for (auto index = 0u; index < queue_size.size(); ++index)
                 do_cts[index] = queue_size[index] <= (_process_buffer_size - 1);
         }
+        lock.unlock();
+
+        for (auto& e : ready)
+            e();
         return std::make_tuple(std::move(message), do_cts, do_close);
     }
 
@@ -880,8 +1225,9 @@ struct shared_process
         stlab::optional<queue_t> message;
         std::array<bool, sizeof...(Args)> do_cts;
         bool do_close = false;
+        bool do_end_of_input = false;
 
-        std::tie(message, do_cts, do_close) = pop_from_queue();
+        std::tie(message, do_cts, do_end_of_input) = pop_from_queue();
 
         std::size_t i = 0;
         tuple_for_each(_upstream, [do_cts, &i](auto& u) {
@@ -903,10 +1249,80 @@ struct shared_process
         }
 
         if (do_close) process_close(_process);
+        if (do_end_of_input) process_end_of_input(_process);
 
         return bool(message);
     }
 
+    bool dequeue_batch() {
+        auto& values = _batch._values;
+        values.clear();
+
+        // An error that ended the last batch is passed on first
+        if (_batch._error) {
+            batch_error();
+            return true;
+        }
+
+        std::array<bool, sizeof...(Args)> do_cts = {{false}};
+        bool do_end_of_input = false;
+        std::vector<packaged_task<>> ready;
+        {
+            std::unique_lock<std::mutex> lock(_process_mutex);
+            const std::size_t limit = _process_buffer_size == 0 ?
+                                          std::numeric_limits<std::size_t>::max() :
+                                          std::size_t(_process_buffer_size);
+            while (!_queue.empty() && values.size() < limit && !_batch._error) {
+                auto message = _queue.front();
+                _queue.pop_front();
+                auto& item = std::get<0>(message);
+                if (static_cast<message_t>(index(item)) == message_t::error)
+                    _batch._error = stlab::get<std::exception_ptr>(item);
+                else
+                    values.push_back(std::move(stlab::get<batch_value_t>(item)));
+            }
+            if (values.empty() && !_batch._error) {
+                std::swap(do_end_of_input, _process_close_queue);
+                _process_final = do_end_of_input;
+            } else {
+                this->admit_waiting(ready);
+                auto queue_size = _queue.size();
+                for (auto index = 0u; index < queue_size.size(); ++index)
+                    do_cts[index] = queue_size[index] <= (_process_buffer_size - 1);
+            }
+        }
+
+        for (auto& e : ready)
+            e();
+
+        std::size_t i = 0;
+        tuple_for_each(_upstream, [do_cts, &i](auto& u) {
+            if (do_cts[i] && u) u->clear_to_send();
+            ++i;
+        });
+
+        if (!values.empty()) {
+            unwrap(*_process).await_batch(values);
+            return true;
+        }
+        if (_batch._error) {
+            batch_error();
+            return true;
+        }
+        process_close(_process);
+        if (do_end_of_input) process_end_of_input(_process);
+        return false;
+    }
+
+    void batch_error() {
+        if constexpr (has_set_process_error_v<unwrap_reference_t<T>>)
+            set_process_error(*_process, std::exchange(_batch._error, nullptr));
+        else {
+            _batch._error = nullptr;
+            process_close(_process);
+        }
+    }
+
     template <typename U>
     auto step() -> std::enable_if_t<has_process_yield_v<unwrap_reference_t<U>>> {
         // in case that the timeout function is just been executed then we have to re-schedule
@@ -917,6 +1333,7 @@ struct shared_process
             return;
         }
         _timeout_function_active = false;
+        ++_timeout_generation;
 
         /*
             While we are waiting we will flush the queue. The assumption here is that work
@@ -927,6 +1344,10 @@ struct shared_process
                 while (get_process_state(_process).first == process_state::await) {
                     if (!dequeue()) break;
                 }
+            } else if constexpr (is_batch_process) {
+                while (get_process_state(_process).first == process_state::await) {
+                    if (!dequeue_batch()) break;
+                }
             } else {
                 if (get_process_state(_process).first == process_state::await) return;
             }
@@ -941,9 +1362,11 @@ struct shared_process
                This process will be considered running until it executes.
             */
             if (state == process_state::yield) {
-                if (std::chrono::duration_cast<std::chrono::nanoseconds>(duration) <= std::chrono::nanoseconds::min())
+                if (std::chrono::duration_cast<std::chrono::nanoseconds>(duration) <=
+                    std::chrono::nanoseconds::min()) {
                     broadcast(unwrap(*_process).yield());
-                else
+                    if (is_final()) yield_final();
+                } else
                     execute_at(duration,
                                _executor)([_weak_this = make_weak_ptr(this->shared_from_this())] {
                         auto _this = _weak_this.lock();
@@ -966,7 +1389,9 @@ struct shared_process
             } else {
                 /* Schedule a timeout. */
                 _timeout_function_active = true;
-                execute_at(duration, _executor)([_weak_this = make_weak_ptr(this->shared_from_this())] {
+                auto weak_this = make_weak_ptr(this->shared_from_this());
+                execute_at(duration, _executor)([_weak_this = std::move(weak_this),
+                                                 _generation = _timeout_generation] {
                     auto _this = _weak_this.lock();
                     // It may be that the complete channel is gone in the meanwhile
                     if (!_this) return;
@@ -976,8 +1401,9 @@ struct shared_process
                         lock_t lock(_this->_timeout_function_control, std::try_to_lock);
                         if (!lock) continue;
 
-                        // we were cancelled
-                        if (get_process_state(_this->_process).first != process_state::yield) {
+                        // we were cancelled, by a later step or by a yield
+                        if (_this->_timeout_generation == _generation &&
+                            get_process_state(_this->_process).first != process_state::yield) {
                             _this->try_broadcast();
                             _this->_timeout_function_active = false;
                         }
@@ -990,6 +1416,21 @@ struct shared_process
         }
     }
 
+    bool is_final() {
+        std::unique_lock<std::mutex> lock(_process_mutex);
+        return _process_final;
+    }
+
+    /*
+        Once the queue is closed clear_to_send() does not run the process again. So the values
+        that the process yields after the close are sent here and then the downstream is closed.
+    */
+    void yield_final() {
+        while (get_process_state(_process).first == process_state::yield)
+            broadcast(unwrap(*_process).yield());
+        task_done();
+    }
+
     void try_broadcast() {
         try {
             if (_process) broadcast(unwrap(*_process).yield());
@@ -1021,7 +1462,8 @@ struct shared_process
         if (message) {
             auto error = find_argument_error(*message);
             if (error) {
-                do_close = true;
+                // Pass the error on, so that a downstream process can handle it
+                broadcast(std::move(*error));
             } else {
                 try {
                     // The message cannot be moved because boost::variant supports r-values just
@@ -1038,12 +1480,39 @@ struct shared_process
     }
 
     void run() {
+        // A process that is stepping on this thread continues in the same task within its quantum
+        auto& context = current_step();
+        if (context._process == this) {
+            context._again = true;
+            return;
+        }
+
         _executor([_p = make_weak_ptr(this->shared_from_this())] {
             auto p = _p.lock();
-            if (p) p->template step<T>();
+            if (p) p->run_quantum();
         });
     }
 
+    void run_quantum() {
+        auto& context = current_step();
+        const auto saved = context;
+        context = step_context{this, false};
+
+        const bool timed = _quantum_duration != std::chrono::nanoseconds::max();
+        const auto start = timed ? std::chrono::steady_clock::now() :
+                                   std::chrono::steady_clock::time_point();
+        std::size_t n = 0;
+        do {
+            context._again = false;
+            step<T>();
+        } while (context._again && ++n < _quantum_messages &&
+                 (!timed || std::chrono::steady_clock::now() - start < _quantum_duration));
+
+        const bool again = context._again;
+        context = saved;
+        if (again) run();
+    }
+
     template <typename... A>
     void broadcast(A&&... args) {
         /*
@@ -1091,9 +1560,28 @@ struct shared_process
         }
     }
 
-    void set_buffer_size(size_t buffer_size) override { _process_buffer_size = buffer_size; }
+    void set_buffer_size(size_t buffer_size) override {
+        std::unique_lock<std::mutex> lock(_process_mutex);
+        _process_buffer_size = buffer_size;
+        if constexpr (has_queue_set_capacity_v<Q>) _queue.set_capacity(buffer_size);
+    }
 
     size_t buffer_size() const override { return _process_buffer_size; }
+
+    void set_quantum(std::size_t messages, std::chrono::nanoseconds duration) {
+        _quantum_messages = (std::max)(messages, std::size_t(1));
+        _quantum_duration = duration;
+    }
+
+    /*
+        Hooks for processes that channel_combiner wires without a receiver, e.g. the partitions of
+        a partitioned stage. add_senders() counts n senders more than the constructor does, for a
+        process whose upstream stands for several processes. set_ready() lets the process run, as
+        receiver::set_ready() does.
+    */
+    void add_senders(std::size_t n) { _sender_count += n; }
+
+    void set_ready() { remove_receiver(); }
 };
 
 /**************************************************************************************************/
@@ -1119,6 +1607,283 @@ struct zip_with_t {
 
 namespace detail {
 
+/*
+    partition_router takes the place of a downstream process of the upstream and sends each value on
+    to one of several partition processes. It gives the upstream a clear to send for a value as
+    soon as the partition of that value has room for it, so a full partition stops the upstream
+    only when the next value belongs to it. Until then the value waits in the router. The router
+    is also the upstream of the partitions, and their clear to send passes the waiting value on.
+*/
+template <typename T, typename U>
+struct partition_router : shared_process_sender<T>, shared_process_receiver<U> {
+    using item_t = variant<U, std::exception_ptr>;
+
+    std::shared_ptr<shared_process_receiver<T>> _upstream;
+    std::vector<std::weak_ptr<shared_process_sender<U>>> _partitions;
+    std::atomic_size_t _sender_count{1};
+
+    mutable std::mutex _mutex;
+    // The value that waits for room in its partition, with the index of the partition
+    stlab::optional<std::pair<std::size_t, item_t>> _waiting;
+    // Makes the future of async_send() for the waiting value ready once it is passed on
+    packaged_task<> _accepted;
+    bool _closed = false;
+
+    explicit partition_router(std::shared_ptr<shared_process_receiver<T>> upstream) :
+        _upstream(std::move(upstream)) {}
+
+    static void send_item(shared_process_sender<U>& p, item_t x) {
+        if (static_cast<message_t>(x.index()) == message_t::error)
+            p.send(std::move(stlab::get<std::exception_ptr>(x)));
+        else
+            p.send(std::move(stlab::get<U>(x)));
+    }
+
+    void close_partitions() {
+        for (const auto& e : _partitions) {
+            auto p = e.lock();
+            if (p) p->remove_sender();
+        }
+    }
+
+    void route(std::size_t i, item_t x, packaged_task<> accepted = {}) {
+        auto p = _partitions[i].lock();
+        if (p) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (p->free_buffer() == 0) {
+                _waiting.emplace(i, std::move(x));
+                _accepted = std::move(accepted);
+                return;
+            }
+        }
+        if (p) send_item(*p, std::move(x));
+        accepted();
+        _upstream->clear_to_send();
+    }
+
+    // As route(), the returned future is ready once x is passed on to its partition
+    future<void> async_route(std::size_t i, item_t x) {
+        auto p = package<void()>(immediate_executor, [] {});
+        route(i, std::move(x), std::move(p.first));
+        return std::move(p.second);
+    }
+
+    void add_sender() override { ++_sender_count; }
+
+    void remove_sender() override {
+        assert(_sender_count > 0);
+        if (--_sender_count != 0) return;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _closed = true;
+            if (_waiting) return; // closed once the waiting value is sent
+        }
+        close_partitions();
+    }
+
+    // The router takes one value at a time, the upstream waits for a clear to send after each
+    std::size_t free_buffer() const override {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _waiting ? 0 : 1;
+    }
+
+    void map(sender<U>) override { assert(false && "partitions are mapped when they are created"); }
+
+    void clear_to_send() override {
+        std::shared_ptr<shared_process_sender<U>> p;
+        stlab::optional<std::pair<std::size_t, item_t>> waiting;
+        packaged_task<> accepted;
+        bool do_close;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (!_waiting) return;
+            p = _partitions[_waiting->first].lock();
+            if (p && p->free_buffer() == 0) return;
+            waiting = std::move(_waiting);
+            _waiting = nullopt;
+            accepted = std::move(_accepted);
+            do_close = _closed;
+        }
+        if (p) send_item(*p, std::move(waiting->second));
+        accepted();
+        if (do_close) close_partitions();
+        _upstream->clear_to_send();
+    }
+
+    void add_receiver() override {}
+    void remove_receiver() override {}
+
+    executor_t executor() const override { return _upstream->executor(); }
+
+    void set_buffer_size(size_t) override {}
+
+    size_t buffer_size() const override { return _upstream->buffer_size(); }
+};
+
+/*
+    key_router sends each value to the partition that the hash of its key selects, so values with
+    equal keys always reach the same partition. An error has no key, it is sent to the first
+    partition.
+*/
+template <typename T, typename K>
+struct key_router : partition_router<T, T> {
+    using partition_value_t = T;
+
+    K _key;
+
+    key_router(std::shared_ptr<shared_process_receiver<T>> upstream, K key) :
+        partition_router<T, T>(std::move(upstream)), _key(std::move(key)) {}
+
+    std::size_t partition(const T& x) const {
+        const auto& key = _key(x);
+        return std::hash<std::decay_t<decltype(key)>>{}(key) % this->_partitions.size();
+    }
+
+    void send(avoid<T> x) override {
+        const auto i = partition(x);
+        this->route(i, std::move(x));
+    }
+
+    void send(std::exception_ptr error) override { this->route(0, std::move(error)); }
+
+    future<void> async_send(avoid<T> x) override {
+        const auto i = partition(x);
+        return this->async_route(i, std::move(x));
+    }
+
+    future<void> async_send(std::exception_ptr error) override {
+        return this->async_route(0, std::move(error));
+    }
+};
+
+/**************************************************************************************************/
+
+// A value or an error together with its position in the input of a parallel_map stage
+template <typename T>
+struct sequenced {
+    std::size_t _sequence;
+    variant<T, std::exception_ptr> _value;
+};
+
+/*
+    sequence_router numbers the values and errors in the order in which they arrive and sends them
+    to the partitions in turn. It is called by the upstream process only, so the numbering needs no
+    synchronization.
+*/
+template <typename T>
+struct sequence_router : partition_router<T, sequenced<T>> {
+    using partition_value_t = sequenced<T>;
+
+    std::size_t _next{0};
+
+    using partition_router<T, sequenced<T>>::partition_router;
+
+    template <typename U>
+    void send_(U&& x) {
+        const auto sequence = _next++;
+        this->route(sequence % this->_partitions.size(),
+                    sequenced<T>{sequence, std::forward<U>(x)});
+    }
+
+    void send(avoid<T> x) override { send_(std::move(x)); }
+
+    void send(std::exception_ptr error) override { send_(std::move(error)); }
+
+    template <typename U>
+    future<void> async_send_(U&& x) {
+        const auto sequence = _next++;
+        return this->async_route(sequence % this->_partitions.size(),
+                                 sequenced<T>{sequence, std::forward<U>(x)});
+    }
+
+    future<void> async_send(avoid<T> x) override { return async_send_(std::move(x)); }
+
+    future<void> async_send(std::exception_ptr error) override {
+        return async_send_(std::move(error));
+    }
+};
+
+// The process of each partition of a parallel_map stage, an exception of f keeps its position
+template <typename F>
+struct sequenced_invoke {
+    F _f;
+
+    template <typename T>
+    auto operator()(sequenced<T> x) const -> sequenced<std::result_of_t<const F&(T)>> {
+        using result_t = std::result_of_t<const F&(T)>;
+        if (static_cast<message_t>(x._value.index()) == message_t::error)
+            return {x._sequence, stlab::get<std::exception_ptr>(x._value)};
+        try {
+            return {x._sequence, result_t(_f(std::move(stlab::get<T>(x._value))))};
+        } catch (...) {
+            return {x._sequence, std::current_exception()};
+        }
+    }
+};
+
+/*
+    reorder yields the results of the partitions of a parallel_map stage in the order of their
+    sequence numbers. A result that arrives early waits in a slot of _pending until all results
+    before it are yielded. Its size is limited by the buffers of the partitions.
+*/
+template <typename R>
+struct reorder {
+    std::size_t _next{0};
+    std::deque<stlab::optional<variant<R, std::exception_ptr>>> _pending;
+
+    void await(sequenced<R> x) {
+        const auto slot = x._sequence - _next;
+        if (_pending.size() <= slot) _pending.resize(slot + 1);
+        _pending[slot] = std::move(x._value);
+    }
+
+    R yield() {
+        auto value = std::move(*_pending.front());
+        _pending.pop_front();
+        ++_next;
+        if (static_cast<message_t>(value.index()) == message_t::error)
+            std::rethrow_exception(stlab::get<std::exception_ptr>(value));
+        return std::move(stlab::get<R>(value));
+    }
+
+    process_state_scheduled state() const {
+        return !_pending.empty() && _pending.front() ? yield_immediate : await_forever;
+    }
+};
+
+/**************************************************************************************************/
+
+/*
+    partition_fanout is the upstream of the process that merges the results of all partitions. It
+    owns the partitions and passes a clear to send on to every partition that is suspended, i.e.
+    that waits for room in the merging process.
+*/
+template <typename P, typename R>
+struct partition_fanout : shared_process_receiver<R> {
+    std::vector<std::shared_ptr<P>> _partitions;
+
+    void map(sender<R>) override { assert(false && "partitions are mapped when they are created"); }
+
+    void clear_to_send() override {
+        for (const auto& e : _partitions)
+            if (e->_process_suspend_count) e->clear_to_send();
+    }
+
+    void add_receiver() override {}
+    void remove_receiver() override {}
+
+    executor_t executor() const override { return _partitions.front()->executor(); }
+
+    void set_buffer_size(size_t buffer_size) override {
+        for (const auto& e : _partitions)
+            e->set_buffer_size(buffer_size);
+    }
+
+    size_t buffer_size() const override { return _partitions.front()->buffer_size(); }
+};
+
+/**************************************************************************************************/
+
 // This helper class is necessary to encapsulate the following functions, because Clang
 // currently has a bug in accepting friend functions with auto return type
 struct channel_combiner {
@@ -1169,6 +1934,63 @@ struct channel_combiner {
 
         return receiver<result_t>(std::move(merge_process));
     }
+
+    /*
+        Creates n partitions made by factory() behind router and merges their results with the
+        process merge.
+    */
+    template <typename T, typename Router, typename F, typename M>
+    static auto partition(const receiver<T>& upstream,
+                          std::shared_ptr<Router> router,
+                          std::size_t n,
+                          F factory,
+                          M merge) {
+        using value_t = typename Router::partition_value_t;
+        using process_t = std::decay_t<decltype(factory())>;
+        using partition_result_t = yield_type<unwrap_reference_t<process_t>, value_t>;
+        using partition_t =
+            shared_process<default_queue_strategy<value_t>, process_t, partition_result_t, value_t>;
+        using result_t = yield_type<unwrap_reference_t<M>, partition_result_t>;
+        using output_t = shared_process<default_queue_strategy<partition_result_t>, M, result_t,
+                                        partition_result_t>;
+        static_assert(!std::is_same<partition_result_t, void>::value,
+                      "A partitioned stage requires a process with a result");
+        assert(n > 0 && "A partitioned stage requires at least one partition");
+
+        auto fanout = std::make_shared<partition_fanout<partition_t, partition_result_t>>();
+        for (std::size_t i = 0; i != n; ++i) {
+            auto p = std::make_shared<partition_t>(router->executor(), factory(), router);
+            router->_partitions.emplace_back(p);
+            fanout->_partitions.push_back(std::move(p));
+        }
+
+        // The constructor counts the fanout as one sender, each partition holds a sender
+        auto output = std::make_shared<output_t>(router->executor(), std::move(merge), fanout);
+        output->add_senders(n - 1);
+        for (const auto& p : fanout->_partitions) {
+            p->map(sender<partition_result_t>(output));
+            p->set_ready();
+        }
+
+        upstream._p->map(sender<T>(std::move(router)));
+        return receiver<result_t>(std::move(output));
+    }
+
+    template <typename T, typename K, typename F>
+    static auto parallel_by_key(const receiver<T>& upstream, std::size_t n, K key, F factory) {
+        return partition(upstream, std::make_shared<key_router<T, K>>(upstream._p, std::move(key)),
+                         n, std::move(factory), identity());
+    }
+
+    template <typename T, typename F>
+    static auto parallel_map(const receiver<T>& upstream, std::size_t n, F f) {
+        using result_t = std::result_of_t<const F&(T)>;
+        static_assert(!std::is_same<result_t, void>::value,
+                      "parallel_map requires a function with a result");
+        return partition(upstream, std::make_shared<sequence_router<T>>(upstream._p), n,
+                         [_f = std::move(f)] { return sequenced_invoke<F>{_f}; },
+                         reorder<result_t>());
+    }
 };
 
 struct zip_helper {
@@ -1180,10 +2002,25 @@ struct zip_helper {
 
 template <typename E, typename T>
 struct channel_ {
-    static auto create(E executor) {
-        auto p = std::make_shared<
-            detail::shared_process<detail::default_queue_strategy<T>, identity, T, T>>(
-            std::move(executor), identity());
+    static auto create(E executor) { return create(std::move(executor), identity()); }
+
+    /*
+        P must pass the values on unchanged like identity. It lives as long as the channel, so it
+        can own state that has to go away when the last receiver is dropped.
+    */
+    template <typename P>
+    static auto create(E executor, P process) {
+        auto p =
+            std::make_shared<detail::shared_process<detail::default_queue_strategy<T>, P, T, T>>(
+                std::move(executor), std::move(process));
+
+        return std::make_pair(sender<T>(p), receiver<T>(p));
+    }
+    template <typename Q>
+    static auto create_queued(E executor, std::size_t buffer_size) {
+        auto p = std::make_shared<detail::shared_process<Q, identity, T, T>>(std::move(executor),
+                                                                            identity());
+        p->set_buffer_size(buffer_size);
 
         return std::make_pair(sender<T>(p), receiver<T>(p));
     }
@@ -1255,12 +2092,186 @@ auto zip(S s, R... r) {
 
 /**************************************************************************************************/
 
+namespace detail {
+
+template <typename K, typename F>
+struct parallel_by_key_t {
+    std::size_t _n;
+    K _key;
+    F _factory;
+};
+
+template <typename F>
+struct parallel_map_t {
+    std::size_t _n;
+    F _f;
+};
+
+} // namespace detail
+
+/*
+ * parallel_by_key(n, key, factory) is a stage that runs n processes, made by factory(), side by
+ * side. Each value goes to the process that the hash of key(value) selects, so the values of one
+ * key are processed in order by the same process. The results of all processes are merged into one
+ * receiver, results of different keys may arrive in any order. The upstream stops while any
+ * partition has a full buffer and the partitions stop while the merged receiver is full.
+ *
+ *     auto result = receive | parallel_by_key(4, [](const order& x) { return x._account; },
+ *                                             [] { return running_balance(); });
+ */
+template <typename K, typename F>
+auto parallel_by_key(std::size_t n, K key, F factory) {
+    return detail::parallel_by_key_t<K, F>{n, std::move(key), std::move(factory)};
+}
+
+/*
+ * parallel_map(n, f) is a stage that calls f for up to n values at the same time on the executor
+ * and sends the results on in the order of the values. The values are numbered and handed to n
+ * partitions in turn, a result that is ready before the ones preceding it waits in a reorder
+ * buffer. As with parallel_by_key the upstream stops while a partition is full and the partitions
+ * stop while the downstream is full, so the reorder buffer stays bounded. An exception of f is sent
+ * on in the place of its result.
+ *
+ *     auto records = lines | parallel_map(4, [](const std::string& x) { return parse(x); });
+ */
+template <typename F>
+auto parallel_map(std::size_t n, F f) {
+    return detail::parallel_map_t<F>{n, std::move(f)};
+}
+
+/**************************************************************************************************/
+
 struct buffer_size 
 {
     std::size_t _value;
     buffer_size(std::size_t b) : _value(b) {}
 };
 
+/*
+ * mpsc_channel<T>(executor, buffer_size) creates a channel for many concurrent senders. They
+ * append without a lock as long as the buffer of the channel has room, see mpsc_queue_strategy.
+ * The channel is opt in, because on a single core the default queue is as fast or faster.
+ */
+template <typename T, typename E>
+auto mpsc_channel(E executor, buffer_size bs = buffer_size{1}) {
+    static_assert(!std::is_same<T, void>::value, "mpsc_channel<void> has no sender to queue for");
+    return detail::channel_<E, T>::template create_queued<detail::mpsc_queue_strategy<T>>(
+        std::move(executor), bs._value);
+}
+
+/*
+ * quantum lets a process handle up to messages values, or values for up to duration, in one task
+ * before it gives the executor back to other tasks. The default is one message per task. The
+ * process still stops when the downstream buffers are full.
+ */
+struct quantum {
+    std::size_t _messages;
+    std::chrono::nanoseconds _duration;
+    quantum(std::size_t messages,
+            std::chrono::nanoseconds duration = std::chrono::nanoseconds::max()) :
+        _messages(messages), _duration(duration) {}
+};
+
+/*
+ * share_immutable is a process that wraps each value once into a copy_on_write. When its result is
+ * broadcast to several receivers they all share that value instead of getting a copy each. The
+ * receivers read the value with read(); a write() makes a copy only then.
+ *
+ *     auto shared = receive | share_immutable{};
+ *     auto a = shared | [](const copy_on_write<image>& x) { ... };
+ *     auto b = shared | [](const copy_on_write<image>& x) { ... };
+ */
+struct share_immutable {
+    template <typename T>
+    copy_on_write<std::decay_t<T>> operator()(T&& x) const {
+        return copy_on_write<std::decay_t<T>>(std::forward<T>(x));
+    }
+};
+
+/*
+ * window<T>(count, duration) is a process that collects values into a std::vector<T> and sends the
+ * vector on when it holds count values or when duration has passed since its first value,
+ * whichever comes first. A partial window is sent at the end of the input; an upstream error is
+ * sent on after the values that came before it. The timeout is only scheduled while a window is partly
+ * filled, an idle window costs nothing. Each window reserves the size of the largest window so far,
+ * up to count, so it is filled without reallocation.
+ *
+ *     auto batches = receive | window<event>(100, std::chrono::milliseconds(10));
+ */
+template <typename T>
+class window {
+    using clock_t = std::chrono::steady_clock;
+    using rep_t = clock_t::duration::rep;
+    static constexpr rep_t no_deadline = std::numeric_limits<rep_t>::max();
+
+    std::size_t _count;
+    std::chrono::nanoseconds _duration;
+    std::vector<T> _values;
+    std::size_t _capacity{0};
+    std::exception_ptr _error;
+    // state() is called concurrently by clear_to_send()
+    std::atomic_bool _yielding{false};
+    std::atomic<rep_t> _deadline{no_deadline};
+
+public:
+    window(std::size_t count, std::chrono::nanoseconds duration = std::chrono::nanoseconds::max()) :
+        _count(count), _duration(duration) {
+        assert(count > 0 && "window count must be at least one");
+    }
+
+    window(window&& x) noexcept :
+        _count(x._count), _duration(x._duration), _values(std::move(x._values)),
+        _capacity(x._capacity), _error(std::move(x._error)), _yielding(x._yielding.load()),
+        _deadline(x._deadline.load()) {}
+
+    void await(T x) {
+        if (_values.empty()) {
+            _values.reserve(_capacity);
+            if (_duration != std::chrono::nanoseconds::max())
+                _deadline =
+                    (clock_t::now() + std::chrono::duration_cast<clock_t::duration>(_duration))
+                        .time_since_epoch()
+                        .count();
+        }
+        _values.push_back(std::move(x));
+        if (_values.size() >= _count) _yielding = true;
+    }
+
+    void set_error(std::exception_ptr error) {
+        _error = std::move(error);
+        _yielding = true;
+    }
+
+    void end_of_input() {
+        if (!_values.empty()) _yielding = true;
+    }
+
+    std::vector<T> yield() {
+        if (_values.empty()) {
+            _yielding = false;
+            std::rethrow_exception(std::exchange(_error, nullptr));
+        }
+
+        _capacity = std::min(_count, std::max(_capacity, _values.size()));
+        _deadline = no_deadline;
+        _yielding = static_cast<bool>(_error);
+        return std::exchange(_values, {});
+    }
+
+    process_state_scheduled state() const {
+        if (_yielding) return yield_immediate;
+
+        const auto deadline = _deadline.load();
+        if (deadline == no_deadline) return await_forever;
+
+        const auto remaining = clock_t::duration(deadline) - clock_t::now().time_since_epoch();
+        if (remaining <= clock_t::duration::zero())
+            return {process_state::await, std::chrono::nanoseconds::min()};
+        return {process_state::await,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(remaining)};
+    }
+};
+
 /**************************************************************************************************/
 
 namespace detail {
@@ -1268,10 +2279,12 @@ namespace detail {
 struct annotations {
     stlab::optional<executor_t> _executor;
     stlab::optional<std::size_t> _buffer_size;
+    stlab::optional<quantum> _quantum;
 
     annotations(executor_t e, std::size_t bs) : _executor(std::move(e)), _buffer_size(bs) {}
     explicit annotations(executor_t e) : _executor(std::move(e)) {}
     explicit annotations(std::size_t bs) : _buffer_size(bs) {}
+    explicit annotations(quantum q) : _quantum(q) {}
 };
 
 template <typename F>
@@ -1361,6 +2374,55 @@ detail::annotated_process<F> operator&(detail::annotated_process<F>&& a, buffer_
     return result;
 }
 
+inline detail::annotations operator&(detail::annotations&& a, quantum q) {
+    a._quantum = q;
+    return std::move(a);
+}
+
+inline detail::annotations operator&(quantum q, detail::annotations&& a) {
+    return std::move(a) & q;
+}
+
+inline detail::annotations operator&(buffer_size bs, quantum q) {
+    return detail::annotations{bs._value} & q;
+}
+
+inline detail::annotations operator&(quantum q, buffer_size bs) { return bs & q; }
+
+inline detail::annotations operator&(const executor& e, quantum q) {
+    return detail::annotations{e._executor} & q;
+}
+
+inline detail::annotations operator&(quantum q, const executor& e) { return e & q; }
+
+template <typename F>
+detail::annotated_process<F> operator&(quantum q, F&& f) {
+    return detail::annotated_process<F>{std::forward<F>(f), detail::annotations{q}};
+}
+
+template <typename F>
+detail::annotated_process<F> operator&(F&& f, quantum q) {
+    return detail::annotated_process<F>{std::forward<F>(f), detail::annotations{q}};
+}
+
+template <typename F>
+detail::annotated_process<F> operator&(executor_task_pair<F>&& etp, quantum q) {
+    detail::annotated_process<F> result{std::move(etp)};
+    result._annotations._quantum = q;
+    return result;
+}
+
+template <typename F>
+detail::annotated_process<F> operator&(quantum q, executor_task_pair<F>&& etp) {
+    return std::move(etp) & q;
+}
+
+template <typename F>
+detail::annotated_process<F> operator&(detail::annotated_process<F>&& a, quantum q) {
+    a._annotations._quantum = q;
+    return std::move(a);
+}
+
 /**************************************************************************************************/
 
 template <typename T>
@@ -1443,6 +2505,10 @@ public:
             detail::default_queue_strategy<T>, F, detail::yield_type<unwrap_reference_t<F>, T>, T>>(
             executor, std::move(ap._f), _p);
 
+        if (ap._annotations._quantum)
+            p->set_quantum(ap._annotations._quantum->_messages,
+                           ap._annotations._quantum->_duration);
+
         _p->map(sender<T>(p));
 
         if (ap._annotations._buffer_size) p->set_buffer_size(*ap._annotations._buffer_size);
@@ -1455,6 +2521,25 @@ public:
         return operator|(detail::annotated_process<F>(std::move(etp)));
     }
 
+    template <typename K, typename F>
+    auto operator|(detail::parallel_by_key_t<K, F> stage) const {
+        if (!_p) throw channel_error(channel_error_codes::broken_channel);
+
+        if (_ready) throw channel_error(channel_error_codes::process_already_running);
+
+        return detail::channel_combiner::parallel_by_key(*this, stage._n, std::move(stage._key),
+                                                         std::move(stage._factory));
+    }
+
+    template <typename F>
+    auto operator|(detail::parallel_map_t<F> stage) const {
+        if (!_p) throw channel_error(channel_error_codes::broken_channel);
+
+        if (_ready) throw channel_error(channel_error_codes::process_already_running);
+
+        return detail::channel_combiner::parallel_map(*this, stage._n, std::move(stage._f));
+    }
+
     auto operator|(sender<T> send) {
         return operator|
             ([_send = std::move(send)](auto&& x) { _send(std::forward<decltype(x)>(x)); });
@@ -1523,6 +2608,24 @@ public:
         if (p) p->send(std::forward<A>(args)...);
     }
 
+    /*
+        Sends x once the buffer of the receiving process has room for it. The returned future is
+        ready when x has been accepted, at once if there is room. Values sent with operator()
+        meanwhile may overtake x. If the channel is gone the future fails with broken_channel.
+    */
+    future<void> async_send(detail::avoid<T> x) const {
+        auto p = _p.lock();
+        if (p) return p->async_send(std::move(x));
+        return detail::broken_channel_future();
+    }
+
+    // Sends error like a value, once the buffer of the receiving process has room for it
+    future<void> async_send(std::exception_ptr error) const {
+        auto p = _p.lock();
+        if (p) return p->async_send(std::move(error));
+        return detail::broken_channel_future();
+    }
+
     optional<std::size_t> free_buffer() const {
         optional<std::size_t> result;
         auto p = _p.lock();
@@ -1581,6 +2684,24 @@ public:
         if (p) p->send(std::forward<A>(args)...);
     }
 
+    /*
+        Sends x once the buffer of the receiving process has room for it. The returned future is
+        ready when x has been accepted, at once if there is room. Values sent with operator()
+        meanwhile may overtake x. If the channel is gone the future fails with broken_channel.
+    */
+    future<void> async_send(detail::avoid<T> x) const {
+        auto p = _p.lock();
+        if (p) return p->async_send(std::move(x));
+        return detail::broken_channel_future();
+    }
+
+    // Sends error like a value, once the buffer of the receiving process has room for it
+    future<void> async_send(std::exception_ptr error) const {
+        auto p = _p.lock();
+        if (p) return p->async_send(std::move(error));
+        return detail::broken_channel_future();
+    }
+
     optional<std::size_t> free_buffer() const {
         optional<std::size_t> result;
         auto p = _p.lock();
@@ -0,0 +1,223 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#ifndef STLAB_CONCURRENCY_CHANNEL_COROUTINE_HPP
+#define STLAB_CONCURRENCY_CHANNEL_COROUTINE_HPP
+
+#include <atomic>
+#include <exception>
+#include <utility>
+
+#include <stlab/concurrency/channel.hpp>
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/optional.hpp>
+
+#if STLAB_FUTURE_COROUTINES_SUPPORT() == 1
+
+/**************************************************************************************************/
+
+namespace stlab {
+
+/**************************************************************************************************/
+
+inline namespace v1 {
+
+/**************************************************************************************************/
+
+template <typename>
+class process_coroutine;
+
+// co_await next_input in a process_coroutine returns the next value, or nullopt once the input
+// is closed.
+struct next_input_t {};
+
+constexpr next_input_t next_input{};
+
+/**************************************************************************************************/
+
+namespace detail {
+
+/**************************************************************************************************/
+
+template <typename R, typename T>
+struct process_coroutine_promise {
+    stlab::optional<T> _input;
+    std::exception_ptr _input_error;
+    stlab::optional<R> _output;
+    std::exception_ptr _error;
+    // True while the coroutine is suspended in a co_yield or failed, state() is called
+    // concurrently by downstream processes.
+    std::atomic_bool _yielding{false};
+
+    process_coroutine<R(T)> get_return_object();
+
+    // The coroutine runs up to its first co_await or co_yield when it is called
+    coro::suspend_never initial_suspend() const noexcept { return {}; }
+
+    coro::suspend_always final_suspend() const noexcept { return {}; }
+
+    void return_void() const {}
+
+    void unhandled_exception() {
+        _error = std::current_exception();
+        _yielding = true;
+    }
+
+    template <typename U>
+    coro::suspend_always yield_value(U&& x) {
+        _output = std::forward<U>(x);
+        _yielding = true;
+        return {};
+    }
+
+    struct input_awaiter {
+        process_coroutine_promise& _promise;
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(coro::coroutine_handle<>) const noexcept {}
+
+        stlab::optional<T> await_resume() {
+            if (_promise._input_error)
+                std::rethrow_exception(std::exchange(_promise._input_error, nullptr));
+            auto result = std::move(_promise._input);
+            _promise._input = nullopt;
+            return result;
+        }
+    };
+
+    input_awaiter await_transform(next_input_t) { return input_awaiter{*this}; }
+};
+
+/**************************************************************************************************/
+
+} // namespace detail
+
+/**************************************************************************************************/
+
+/*
+ * process_coroutine<R(T)> is a channel process that is written as a coroutine. The coroutine
+ * receives values of type T with co_await next_input and sends values of type R downstream with
+ * co_yield. Once the input is closed, co_await next_input returns nullopt and the coroutine may
+ * yield the remaining values before it returns. An error from upstream is thrown by co_await
+ * next_input; an exception that leaves the coroutine is sent downstream and ends the process.
+ *
+ * The coroutine is resumed directly by the shared process on its executor, so the buffer size
+ * and the executor of the process apply as for any other process and there is no additional
+ * task per element.
+ *
+ *     process_coroutine<int(int)> running_sum() {
+ *         int sum = 0;
+ *         while (auto x = co_await next_input)
+ *             co_yield sum += *x;
+ *     }
+ *
+ *     auto result = receive | running_sum();
+ */
+template <typename R, typename T>
+class process_coroutine<R(T)> {
+public:
+    using promise_type = detail::process_coroutine_promise<R, T>;
+
+private:
+    using handle_t = detail::coro::coroutine_handle<promise_type>;
+
+    handle_t _handle;
+
+    explicit process_coroutine(handle_t handle) : _handle(handle) {}
+
+    friend promise_type;
+
+    void resume() {
+        _handle.resume();
+        auto& promise = _handle.promise();
+        if (promise._error && !promise._output) {
+            promise._yielding = false;
+            std::rethrow_exception(std::exchange(promise._error, nullptr));
+        }
+    }
+
+public:
+    process_coroutine(process_coroutine&& x) noexcept :
+        _handle(std::exchange(x._handle, nullptr)) {}
+
+    process_coroutine& operator=(process_coroutine&& x) noexcept {
+        if (this != &x) {
+            if (_handle) _handle.destroy();
+            _handle = std::exchange(x._handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~process_coroutine() {
+        if (_handle) _handle.destroy();
+    }
+
+    void await(T x) {
+        if (_handle.done()) return;
+        _handle.promise()._input = std::move(x);
+        resume();
+    }
+
+    void set_error(std::exception_ptr error) {
+        if (_handle.done()) return;
+        _handle.promise()._input_error = std::move(error);
+        resume();
+    }
+
+    void end_of_input() {
+        if (_handle.done()) return;
+        resume();
+    }
+
+    R yield() {
+        auto& promise = _handle.promise();
+        if (!promise._output) {
+            promise._yielding = false;
+            std::rethrow_exception(std::exchange(promise._error, nullptr));
+        }
+
+        R result = std::move(*promise._output);
+        promise._output = nullopt;
+        promise._yielding = static_cast<bool>(promise._error);
+        if (!_handle.done()) _handle.resume();
+        return result;
+    }
+
+    process_state_scheduled state() const {
+        return _handle.promise()._yielding ? yield_immediate : await_forever;
+    }
+};
+
+/**************************************************************************************************/
+
+namespace detail {
+
+template <typename R, typename T>
+process_coroutine<R(T)> process_coroutine_promise<R, T>::get_return_object() {
+    return process_coroutine<R(T)>(
+        coro::coroutine_handle<process_coroutine_promise>::from_promise(*this));
+}
+
+} // namespace detail
+
+/**************************************************************************************************/
+
+} // namespace v1
+
+/**************************************************************************************************/
+
+} // namespace stlab
+
+/**************************************************************************************************/
+
+#endif
+
+#endif // STLAB_CONCURRENCY_CHANNEL_COROUTINE_HPP
+
+/**************************************************************************************************/
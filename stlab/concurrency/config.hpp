@@ -82,6 +82,8 @@
         #define STLAB_CPP_VERSION_PRIVATE() 14
     #elif __cplusplus == 201703L
         #define STLAB_CPP_VERSION_PRIVATE() 17
+    #elif __cplusplus == 202002L
+        #define STLAB_CPP_VERSION_PRIVATE() 20
     #else
         #warning Unknown version of C+; assuming C++20.
         #define STLAB_CPP_VERSION_PRIVATE() 20
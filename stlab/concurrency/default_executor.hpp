@@ -244,14 +244,30 @@ private:
 class notification_queue {
     using lock_t = std::unique_lock<std::mutex>;
     std::deque<task<void()>> _q;
-    std::mutex _queue_mutex;
+    mutable std::mutex _queue_mutex;
+    std::mutex* _ready_mutex{nullptr};
     std::condition_variable* _ready{nullptr};
 
+    /*
+        The waiting thread checks its queues and waits while it holds the mutex of its context, so
+        taking that mutex before the notification ensures that the notification is not lost.
+    */
+    void notify() {
+        { lock_t lock{*_ready_mutex}; }
+        _ready->notify_all();
+    }
+
 public:
-    void set_context(std::condition_variable& cv) {
+    void set_context(std::mutex& mutex, std::condition_variable& cv) {
+        _ready_mutex = &mutex;
         _ready = &cv;
     }
 
+    bool empty() const {
+        lock_t lock{_queue_mutex};
+        return _q.empty();
+    }
+
     bool try_pop(task<void()>& x) {
         lock_t lock{_queue_mutex, std::try_to_lock};
         if (!lock || _q.empty()) return false;
@@ -276,7 +292,7 @@ public:
             if (!lock) return false;
             _q.emplace_back(std::forward<F>(f));
         }
-        _ready->notify_all();
+        notify();
         return true;
     }
 
@@ -286,7 +302,7 @@ public:
             lock_t lock{_queue_mutex};
             _q.emplace_back(std::forward<F>(f));
         }
-        _ready->notify_all();
+        notify();
     }
 };
 
@@ -328,6 +344,9 @@ class priority_task_system {
 
             {
                 lock_t lock{_thread_contexts[i]._mutex};
+                // A task that was pushed after the spinning above is taken before waiting
+                for (auto& q : _q)
+                    if (!q[i].empty()) goto begin;
                 if (!_done) {
                     _thread_contexts[i]._ready.wait(lock);
                     goto begin;
@@ -343,7 +362,7 @@ public:
             std::vector<notification_queue> queues{_count};
             std::swap(q, queues);
             for (unsigned n = 0; n != _count; ++n) {
-                q[n].set_context(_thread_contexts[n]._ready);
+                q[n].set_context(_thread_contexts[n]._mutex, _thread_contexts[n]._ready);
             }
         }
         for (unsigned n = 0; n != _count; ++n) {
@@ -353,8 +372,10 @@ public:
 
     ~priority_task_system() {
         _done = true;
-        for (auto& context : _thread_contexts)
+        for (auto& context : _thread_contexts) {
+            { lock_t lock{context._mutex}; }
             context._ready.notify_all();
+        }
 
         for (auto& context : _thread_contexts)
             context._thread.join();
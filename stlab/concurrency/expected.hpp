@@ -0,0 +1,104 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#ifndef STLAB_CONCURRENCY_EXPECTED_HPP
+#define STLAB_CONCURRENCY_EXPECTED_HPP
+
+#include <cassert>
+#include <exception>
+#include <utility>
+
+#include <stlab/concurrency/optional.hpp>
+
+/**************************************************************************************************/
+
+namespace stlab {
+
+/**************************************************************************************************/
+
+inline namespace v1 {
+
+/**************************************************************************************************/
+
+/*
+ * expected holds either a value or the error of a failed future. In contrast to get_try() on a
+ * future, inspecting the error does not rethrow it. Only value() rethrows a contained error.
+ */
+template <typename T>
+class expected {
+    stlab::optional<T> _value;
+    std::exception_ptr _error;
+
+public:
+    using value_type = T;
+
+    expected(T x) : _value(std::move(x)) {}
+    expected(std::exception_ptr error) : _error(std::move(error)) { assert(_error); }
+
+    bool has_value() const { return !_error; }
+    explicit operator bool() const { return has_value(); }
+
+    const std::exception_ptr& error() const { return _error; }
+
+    T& value() & {
+        if (_error) std::rethrow_exception(_error);
+        return *_value;
+    }
+
+    const T& value() const& {
+        if (_error) std::rethrow_exception(_error);
+        return *_value;
+    }
+
+    T&& value() && {
+        if (_error) std::rethrow_exception(_error);
+        return std::move(*_value);
+    }
+
+    // The following accessors require has_value()
+    T& operator*() & { return *_value; }
+    const T& operator*() const& { return *_value; }
+    T&& operator*() && { return std::move(*_value); }
+
+    T* operator->() { return &*_value; }
+    const T* operator->() const { return &*_value; }
+};
+
+template <>
+class expected<void> {
+    std::exception_ptr _error;
+
+public:
+    using value_type = void;
+
+    expected() = default;
+    expected(std::exception_ptr error) : _error(std::move(error)) { assert(_error); }
+
+    bool has_value() const { return !_error; }
+    explicit operator bool() const { return has_value(); }
+
+    const std::exception_ptr& error() const { return _error; }
+
+    void value() const {
+        if (_error) std::rethrow_exception(_error);
+    }
+};
+
+/**************************************************************************************************/
+
+} // namespace v1
+
+/**************************************************************************************************/
+
+} // namespace stlab
+
+/**************************************************************************************************/
+
+#endif // STLAB_CONCURRENCY_EXPECTED_HPP
+
+/**************************************************************************************************/
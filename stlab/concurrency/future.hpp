@@ -10,15 +10,20 @@
 #define STLAB_CONCURRENCY_FUTURE_HPP
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cassert>
+#include <cstdint>
 #include <initializer_list>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 #include <stlab/concurrency/config.hpp>
 #include <stlab/concurrency/executor_base.hpp>
+#include <stlab/concurrency/expected.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
 #include <stlab/concurrency/optional.hpp>
 #include <stlab/concurrency/task.hpp>
 #include <stlab/concurrency/traits.hpp>
@@ -30,8 +35,15 @@
 // as long as VS 2017 still accepts await as keyword, it is necessary to disable coroutine
 // support for the channels tests
 #ifdef __has_include
-#if __has_include(<experimental/coroutine>) && STLAB_FUTURE_COROUTINES
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine) && STLAB_FUTURE_COROUTINES
+#define STLAB_FUTURE_COROUTINES_SUPPORT() 1
+#define STLAB_FUTURE_COROUTINES_PRIVATE_STD() 1
+#include <coroutine>
+#include <stlab/concurrency/default_executor.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+#elif __has_include(<experimental/coroutine>) && STLAB_FUTURE_COROUTINES
 #define STLAB_FUTURE_COROUTINES_SUPPORT() 1
+#define STLAB_FUTURE_COROUTINES_PRIVATE_STD() 0
 #include <experimental/coroutine>
 #include <stlab/concurrency/default_executor.hpp>
 #include <stlab/concurrency/immediate_executor.hpp>
@@ -151,6 +163,19 @@ struct result_of_when_any_t {
     using result_type = typename std::result_of<F(R, size_t)>::type;
 };
 
+template <typename F, typename T>
+struct result_of_when_n_t;
+
+template <typename F>
+struct result_of_when_n_t<F, void> {
+    using result_type = typename std::result_of<F()>::type;
+};
+
+template <typename F, typename T>
+struct result_of_when_n_t {
+    using result_type = typename std::result_of<F(std::vector<T>)>::type;
+};
+
 template <typename T>
 bool unique_usage(const std::shared_ptr<T>& p) {
     return p.use_count() == 1;
@@ -208,14 +233,42 @@ struct reduced_ {
 template <typename T>
 using reduced_t = typename reduced_<T>::type;
 
-template <typename T>
-struct reduction_helper;
-
 /**************************************************************************************************/
 
 template <typename T, typename = void>
 struct value_;
 
+template <typename T, typename E, typename F>
+void attach_continuation(const future<T>&, E, F&&);
+
+template <typename R, typename E, typename F>
+auto package_deferred(E, F&&) -> future<R>;
+
+template <typename T>
+struct make_expected {
+    template <typename F>
+    static expected<T> go(F&& x) {
+        if (auto error = x.exception(); error) return expected<T>(std::move(error));
+        return expected<T>(std::move(*std::forward<F>(x).get_try()));
+    }
+};
+
+template <>
+struct make_expected<void> {
+    template <typename F>
+    static expected<void> go(F&& x) {
+        if (auto error = x.exception(); error) return expected<void>(std::move(error));
+        return expected<void>();
+    }
+};
+
+template <typename T, typename F>
+auto expected_continuation(F&& f) {
+    return [_f = std::forward<F>(f)](auto&& x) mutable {
+        return std::move(_f)(make_expected<T>::go(std::forward<decltype(x)>(x)));
+    };
+}
+
 } // namespace detail
 
 /**************************************************************************************************/
@@ -230,7 +283,7 @@ namespace detail {
 
 /**************************************************************************************************/
 
-template <typename>
+template <typename, typename>
 struct shared;
 template <typename, typename = void>
 struct shared_base;
@@ -255,20 +308,81 @@ struct shared_task {
 
 /**************************************************************************************************/
 
+/*
+ * state_word combines the lock, the ready and the deferred flag of a shared state in a single
+ * byte. The lock is only held for a few instructions to register or take the continuations, so
+ * spinning is cheaper than a std::mutex, which is 40 bytes on common platforms and may need a
+ * system call. It models BasicLockable so it can be used with std::unique_lock.
+ */
+class state_word {
+    static constexpr std::uint8_t locked = 1;
+    static constexpr std::uint8_t ready = 2;
+    static constexpr std::uint8_t deferred = 4;
+
+    std::atomic<std::uint8_t> _state{0};
+
+public:
+    void lock() {
+        std::uint8_t expected = _state.load(std::memory_order_relaxed) & std::uint8_t(~locked);
+        while (!_state.compare_exchange_weak(expected, expected | locked,
+                                             std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+            if (expected & locked) {
+                std::this_thread::yield();
+                expected &= std::uint8_t(~locked);
+            }
+        }
+    }
+
+    void unlock() { _state.fetch_and(std::uint8_t(~locked), std::memory_order_release); }
+
+    bool is_ready() const { return (_state.load(std::memory_order_acquire) & ready) != 0; }
+
+    void set_ready() { _state.fetch_or(ready, std::memory_order_release); }
+
+    void set_deferred() { _state.fetch_or(deferred, std::memory_order_relaxed); }
+
+    // Must be called while locked, returns true only for the first caller after set_deferred()
+    bool take_deferred() {
+        return (_state.load(std::memory_order_relaxed) & deferred) &&
+               (_state.fetch_and(std::uint8_t(~deferred), std::memory_order_relaxed) & deferred);
+    }
+};
+
+/**************************************************************************************************/
+
+/*
+ * Returns the task that runs the promise of a continuation. If errors are forwarded and the source
+ * failed, the continuation is not called but its future gets the error directly. So errors are
+ * passed along a chain of then continuations without being rethrown and caught in each step.
+ */
+template <typename T, typename P>
+task<void()> continuation_task(const std::shared_ptr<shared_base<T>>& source, P promise,
+                               bool forward_error) {
+    if (!forward_error) return task<void()>(std::move(promise));
+
+    return [_source = std::weak_ptr<shared_base<T>>(source), _promise = std::move(promise)] {
+        auto p = _source.lock();
+        if (p && p->_exception)
+            _promise.set_exception(p->_exception);
+        else
+            _promise();
+    };
+}
+
+/**************************************************************************************************/
+
 template <typename T>
 struct shared_base<T, enable_if_copyable<T>> : std::enable_shared_from_this<shared_base<T>> {
     using then_t = std::vector<std::pair<executor_t, task<void()>>>;
 
     executor_t _executor;
     stlab::optional<T> _result;
-    reduction_helper<T> _reduction_helper;
     std::exception_ptr _exception;
-    std::mutex _mutex;
-    std::atomic_bool _ready{false};
+    state_word _state;
     then_t _then;
 
     explicit shared_base(executor_t s) : _executor(std::move(s)) {}
-
     void reset() { _then.clear(); }
 
     template <typename F>
@@ -281,7 +395,8 @@ struct shared_base<T, enable_if_copyable<T>> : std::enable_shared_from_this<shar
         return recover(std::forward<E>(executor),
                        [_f = std::forward<F>(f)](const auto& x) {
                             return _f(x._p->get_ready()); 
-                       });
+                       },
+                       true);
     }
 
     template <typename F>
@@ -290,19 +405,15 @@ struct shared_base<T, enable_if_copyable<T>> : std::enable_shared_from_this<shar
     }
 
     template <typename E, typename F>
-    auto recover(E executor, F&& f) {
+    auto recover(E executor, F&& f, bool forward_error = false) {
         auto p = package<std::result_of_t<F(future<T>)>()>(
             executor, [_f = std::forward<F>(f), _p = future<T>(this->shared_from_this())]() mutable {
                 return std::move(_f)(std::move(_p));
             });
 
-        bool ready;
-        {
-            std::unique_lock<std::mutex> lock(_mutex);
-            ready = _ready;
-            if (!ready) _then.emplace_back(std::move(executor), std::move(p.first));
-        }
-        if (ready) executor(std::move(p.first));
+        continue_with(std::move(executor),
+                      continuation_task(this->shared_from_this(), std::move(p.first),
+                                        forward_error));
 
         return reduce(std::move(p.second));
     }
@@ -316,7 +427,7 @@ struct shared_base<T, enable_if_copyable<T>> : std::enable_shared_from_this<shar
     auto then_r(bool unique, E&& executor, F&& f) {
         return recover_r(unique, std::forward<E>(executor), [_f = std::forward<F>(f)](auto&& x) mutable {
             return std::move(_f)(std::move(*(std::forward<decltype(x)>(x).get_try())));
-        });
+        }, true);
     }
 
     template <typename F>
@@ -325,23 +436,40 @@ struct shared_base<T, enable_if_copyable<T>> : std::enable_shared_from_this<shar
     }
 
     template <typename E, typename F>
-    auto recover_r(bool unique, E&& executor, F&& f) {
-        if (!unique) return recover(std::forward<E>(executor), std::forward<F>(f));
+    auto recover_r(bool unique, E&& executor, F&& f, bool forward_error = false) {
+        if (!unique) return recover(std::forward<E>(executor), std::forward<F>(f), forward_error);
 
         auto p = package<std::result_of_t<F(future<T>)>()>(
             executor, [_f = std::forward<F>(f), _p = future<T>(this->shared_from_this())]() mutable {
                 return _f(std::move(_p));
             });
 
+        continue_with(std::forward<E>(executor),
+                      continuation_task(this->shared_from_this(), std::move(p.first),
+                                        forward_error));
+
+        return reduce(std::move(p.second));
+    }
+
+    // Attaches f without a shared state of its own, it is executed like any other continuation
+    void continue_with(executor_t executor, task<void()> f) {
         bool ready;
+        typename then_t::value_type deferred;
         {
-            std::unique_lock<std::mutex> lock(_mutex);
-            ready = _ready;
-            if (!ready) _then.emplace_back(std::forward<E>(executor), std::move(p.first));
+            std::unique_lock<state_word> lock(_state);
+            ready = _state.is_ready();
+            if (!ready) {
+                if (_state.take_deferred()) {
+                    deferred = std::move(_then.back());
+                    _then.clear();
+                }
+                _then.emplace_back(std::move(executor), std::move(f));
+            }
         }
-        if (ready) executor(std::move(p.first));
-
-        return reduce(std::move(p.second));
+        if (ready)
+            executor(std::move(f));
+        else if (deferred.second)
+            deferred.first(std::move(deferred.second));
     }
 
     template <typename R>
@@ -358,9 +486,9 @@ struct shared_base<T, enable_if_copyable<T>> : std::enable_shared_from_this<shar
         _exception = std::move(error);
         then_t then;
         {
-            std::unique_lock<std::mutex> lock(_mutex);
+            std::unique_lock<state_word> lock(_state);
             then = move(_then);
-            _ready = true;
+            _state.set_ready();
         }
         // propagate exception with scheduling
         for (auto& e : then) {
@@ -371,14 +499,14 @@ struct shared_base<T, enable_if_copyable<T>> : std::enable_shared_from_this<shar
     template <typename F, typename... Args>
     void set_value(F& f, Args&&... args);
 
-    bool is_ready() const& { return _ready; }
+    bool is_ready() const& { return _state.is_ready(); }
 
-    // get_ready() is called internally on continuations when we know _ready is true;
+    // get_ready() is called internally on continuations when we know the state is ready;
     auto get_ready() -> const T& {
 #ifndef NDEBUG
         {
-            std::unique_lock<std::mutex> lock(_mutex);
-            assert(_ready && "FATAL (sean.parent) : get_ready() called but not ready!");
+            std::unique_lock<state_word> lock(_state);
+            assert(_state.is_ready() && "FATAL (sean.parent) : get_ready() called but not ready!");
         }
 #endif
         if (_exception) std::rethrow_exception(_exception);
@@ -388,8 +516,8 @@ struct shared_base<T, enable_if_copyable<T>> : std::enable_shared_from_this<shar
     auto get_try() -> stlab::optional<T> {
         bool ready = false;
         {
-            std::unique_lock<std::mutex> lock(_mutex);
-            ready = _ready;
+            std::unique_lock<state_word> lock(_state);
+            ready = _state.is_ready();
         }
         if (ready) {
             if (_exception) std::rethrow_exception(_exception);
@@ -403,8 +531,8 @@ struct shared_base<T, enable_if_copyable<T>> : std::enable_shared_from_this<shar
 
         bool ready = false;
         {
-            std::unique_lock<std::mutex> lock(_mutex);
-            ready = _ready;
+            std::unique_lock<state_word> lock(_state);
+            ready = _state.is_ready();
         }
         if (ready) {
             if (_exception) std::rethrow_exception(_exception);
@@ -422,14 +550,11 @@ struct shared_base<T, enable_if_not_copyable<T>> : std::enable_shared_from_this<
 
     executor_t _executor;
     stlab::optional<T> _result;
-    reduction_helper<T> _reduction_helper;
     std::exception_ptr _exception;
-    std::mutex _mutex;
-    std::atomic_bool _ready{false};
+    state_word _state;
     then_t _then;
 
     explicit shared_base(executor_t s) : _executor(std::move(s)) {}
-
     void reset() { _then.second = task<void()>{}; }
 
     template <typename F>
@@ -441,7 +566,7 @@ struct shared_base<T, enable_if_not_copyable<T>> : std::enable_shared_from_this<
     auto then_r(bool unique, E&& executor, F&& f) {
         return recover_r(unique, std::forward<E>(executor), [_f = std::forward<F>(f)](auto&& x) {
             return std::move(_f)(std::move(*std::forward<decltype(x)>(x).get_try()));
-        });
+        }, true);
     }
 
     template <typename F>
@@ -450,22 +575,37 @@ struct shared_base<T, enable_if_not_copyable<T>> : std::enable_shared_from_this<
     }
 
     template <typename E, typename F>
-    auto recover_r(bool, E executor, F&& f) {
+    auto recover_r(bool, E executor, F&& f, bool forward_error = false) {
         // rvalue case unique is assumed.
         auto p = package<std::result_of_t<F(future<T>)>()>(
-            executor, [_f = std::forward<F>(f), _p = future<T>(this->shared_from_this())]() {
-                return _f(std::move(_p));
+            executor,
+            [_f = std::forward<F>(f), _p = future<T>(this->shared_from_this())]() mutable {
+                return std::move(_f)(std::move(_p));
             });
 
+        continue_with(std::move(executor),
+                      continuation_task(this->shared_from_this(), std::move(p.first),
+                                        forward_error));
+
+        return reduce(std::move(p.second));
+    }
+
+    // Attaches f without a shared state of its own, it is executed like any other continuation
+    void continue_with(executor_t executor, task<void()> f) {
         bool ready;
+        then_t deferred;
         {
-            std::unique_lock<std::mutex> lock(_mutex);
-            ready = _ready;
-            if (!ready) _then = {std::move(executor), std::move(p.first)};
+            std::unique_lock<state_word> lock(_state);
+            ready = _state.is_ready();
+            if (!ready) {
+                if (_state.take_deferred()) deferred = std::move(_then);
+                _then = {std::move(executor), std::move(f)};
+            }
         }
-        if (ready) executor(std::move(p.first));
-
-        return reduce(std::move(p.second));
+        if (ready)
+            executor(std::move(f));
+        else if (deferred.second)
+            deferred.first(std::move(deferred.second));
     }
 
     template <typename R>
@@ -482,9 +622,9 @@ struct shared_base<T, enable_if_not_copyable<T>> : std::enable_shared_from_this<
         _exception = std::move(error);
         then_t then;
         {
-            std::unique_lock<std::mutex> lock(_mutex);
+            std::unique_lock<state_word> lock(_state);
             if (_then.second) then = std::move(_then);
-            _ready = true;
+            _state.set_ready();
         }
         // propagate exception without scheduling
         if (then.second) then.second();
@@ -492,15 +632,15 @@ struct shared_base<T, enable_if_not_copyable<T>> : std::enable_shared_from_this<
     template <typename F, typename... Args>
     void set_value(F& f, Args&&... args);
 
-    bool is_ready() const { return _ready; }
+    bool is_ready() const { return _state.is_ready(); }
 
     auto get_try() -> stlab::optional<T> { return get_try_r(true); }
 
     auto get_try_r(bool) -> stlab::optional<T> {
         bool ready = false;
         {
-            std::unique_lock<std::mutex> lock(_mutex);
-            ready = _ready;
+            std::unique_lock<state_word> lock(_state);
+            ready = _state.is_ready();
         }
         if (ready) {
             if (_exception) std::rethrow_exception(_exception);
@@ -518,12 +658,10 @@ struct shared_base<void> : std::enable_shared_from_this<shared_base<void>> {
 
     executor_t _executor;
     std::exception_ptr _exception;
-    std::mutex _mutex;
-    std::atomic_bool _ready{false};
+    state_word _state;
     then_t _then;
 
     explicit shared_base(executor_t s) : _executor(std::move(s)) {}
-
     void reset() { _then.clear(); }
 
     template <typename F>
@@ -533,10 +671,9 @@ struct shared_base<void> : std::enable_shared_from_this<shared_base<void>> {
 
     template <typename E, typename F>
     auto then(E&& executor, F&& f) {
-        return recover(std::forward<E>(executor), [_f = std::forward<F>(f)](auto x) mutable {
-            x.get_try(); // throw if error
+        return recover(std::forward<E>(executor), [_f = std::forward<F>(f)](auto) mutable {
             return std::move(_f)();
-        });
+        }, true);
     }
 
     template <typename F>
@@ -555,7 +692,8 @@ struct shared_base<void> : std::enable_shared_from_this<shared_base<void>> {
     }
 
     template <typename E, typename F>
-    auto recover(E&& executor, F&& f) -> future<reduced_t<std::result_of_t<F(future<void>)>>>;
+    auto recover(E&& executor, F&& f, bool forward_error = false)
+        -> future<reduced_t<std::result_of_t<F(future<void>)>>>;
 
     template <typename F>
     auto recover_r(bool, F&& f) {
@@ -567,6 +705,27 @@ struct shared_base<void> : std::enable_shared_from_this<shared_base<void>> {
         return recover(std::forward<E>(executor), std::forward<F>(f));
     }
 
+    // Attaches f without a shared state of its own, it is executed like any other continuation
+    void continue_with(executor_t executor, task<void()> f) {
+        bool ready;
+        typename then_t::value_type deferred;
+        {
+            std::unique_lock<state_word> lock(_state);
+            ready = _state.is_ready();
+            if (!ready) {
+                if (_state.take_deferred()) {
+                    deferred = std::move(_then.back());
+                    _then.clear();
+                }
+                _then.emplace_back(std::move(executor), std::move(f));
+            }
+        }
+        if (ready)
+            executor(std::move(f));
+        else if (deferred.second)
+            deferred.first(std::move(deferred.second));
+    }
+
     template <typename R>
     auto reduce(R&& r) {
         return std::forward<R>(r);
@@ -581,9 +740,9 @@ struct shared_base<void> : std::enable_shared_from_this<shared_base<void>> {
         _exception = std::move(error);
         then_t then;
         {
-            std::unique_lock<std::mutex> lock(_mutex);
+            std::unique_lock<state_word> lock(_state);
             then = std::move(_then);
-            _ready = true;
+            _state.set_ready();
         }
         // propagate exception with scheduling
         for (auto& e : then) {
@@ -591,13 +750,13 @@ struct shared_base<void> : std::enable_shared_from_this<shared_base<void>> {
         }
     }
 
-    bool is_ready() const& { return _ready; }
+    bool is_ready() const& { return _state.is_ready(); }
 
     auto get_try() -> bool {
         bool ready = false;
         {
-            std::unique_lock<std::mutex> lock(_mutex);
-            ready = _ready;
+            std::unique_lock<state_word> lock(_state);
+            ready = _state.is_ready();
         }
         if (ready) {
             if (_exception) std::rethrow_exception(_exception);
@@ -612,29 +771,31 @@ struct shared_base<void> : std::enable_shared_from_this<shared_base<void>> {
     void set_value(F& f, Args&&... args);
 };
 
-template <typename R, typename... Args>
-struct shared<R(Args...)> : shared_base<R>, shared_task<Args...> {
-    using function_t = task<R(Args...)>;
-
+/*
+ * The function is stored with its own type instead of a type erased task, so a packaged task needs
+ * only one allocation that is just as large as needed. The function is destroyed as soon as it was
+ * called or the promise is broken, so it does not outlive the point at which the result is set.
+ */
+template <typename R, typename... Args, typename F>
+struct shared<R(Args...), F> : shared_base<R>, shared_task<Args...> {
     std::atomic_size_t _promise_count;
-    function_t _f;
+    stlab::optional<F> _f;
 
-    template <typename F>
-    shared(executor_t s, F&& f) : shared_base<R>(std::move(s)), _f(std::forward<F>(f)) {
+    template <typename G>
+    shared(executor_t s, G&& f) : shared_base<R>(std::move(s)), _f(std::forward<G>(f)) {
         _promise_count = 1;
     }
 
-
     void remove_promise() override {
         if (std::is_same<R, reduced_t<R>>::value) {
             if (--_promise_count == 0) {
-                std::unique_lock<std::mutex> lock(this->_mutex);
-                if (!this->_ready) {
+                std::unique_lock<state_word> lock(this->_state);
+                if (!this->_state.is_ready()) {
                     this->reset();
-                    _f = function_t();
+                    _f = nullopt;
                     this->_exception =
                         std::make_exception_ptr(future_error(future_error_codes::broken_promise));
-                    this->_ready = true;
+                    this->_state.set_ready();
                 }
             }
         } else {
@@ -646,14 +807,17 @@ struct shared<R(Args...)> : shared_base<R>, shared_task<Args...> {
 
     void operator()(Args... args) override {
         if (_f) try {
-                this->set_value(_f, std::move(args)...);
+                this->set_value(*_f, std::move(args)...);
             } catch (...) {
                 this->set_exception(std::current_exception());
         }
-        _f = function_t();
+        _f = nullopt;
     }
 
-    void set_error(std::exception_ptr error) override { this->set_exception(std::move(error)); }
+    void set_error(std::exception_ptr error) override {
+        this->set_exception(std::move(error));
+        _f = nullopt;
+    }
 };
 
 /**************************************************************************************************/
@@ -730,11 +894,18 @@ class [[nodiscard]] future<T, enable_if_copyable<T>> {
         -> std::pair<detail::packaged_task_from_signature_t<Signature>,
                      future<detail::result_of_t_<Signature>>>;
 
-    friend struct detail::shared_base<T>;
+    template <typename, typename>
+    friend struct detail::shared_base;
 
     template <typename, typename>
     friend struct detail::value_;
 
+    template <typename U, typename E, typename F>
+    friend void detail::attach_continuation(const future<U>&, E, F&&);
+
+    template <typename R, typename E, typename F>
+    friend auto detail::package_deferred(E, F&&) -> future<R>;
+
 public:
     using result_type = T;
 
@@ -808,6 +979,18 @@ public:
         return recover(std::move(etp)._executor, std::move(etp)._f);
     }
 
+    // Like recover, but f gets an expected<T>, so that an error can be handled without a throw
+    template <typename F>
+    auto then_expected(F&& f) const& {
+        return recover(detail::expected_continuation<T>(std::forward<F>(f)));
+    }
+
+    template <typename E, typename F>
+    auto then_expected(E&& executor, F&& f) const& {
+        return recover(std::forward<E>(executor),
+                       detail::expected_continuation<T>(std::forward<F>(f)));
+    }
+
     template <typename F>
     auto recover(F&& f) && {
         return _p->recover_r(unique_usage(_p), std::forward<F>(f));
@@ -828,6 +1011,17 @@ public:
         return std::move(*this).recover(std::move(etp)._executor, std::move(etp)._f);
     }
 
+    template <typename F>
+    auto then_expected(F&& f) && {
+        return std::move(*this).recover(detail::expected_continuation<T>(std::forward<F>(f)));
+    }
+
+    template <typename E, typename F>
+    auto then_expected(E&& executor, F&& f) && {
+        return std::move(*this).recover(std::forward<E>(executor),
+                                        detail::expected_continuation<T>(std::forward<F>(f)));
+    }
+
     void detach() const {
         (void)then([_hold = _p](auto) {}, [](const auto&) {});
     }
@@ -869,7 +1063,14 @@ class [[nodiscard]] future<void, void> {
     template <typename, typename>
     friend struct detail::value_;
 
-    friend struct detail::shared_base<void>;
+    template <typename, typename>
+    friend struct detail::shared_base;
+
+    template <typename U, typename E, typename F>
+    friend void detail::attach_continuation(const future<U>&, E, F&&);
+
+    template <typename R, typename E, typename F>
+    friend auto detail::package_deferred(E, F&&) -> future<R>;
 
 public:
     using result_type = void;
@@ -944,6 +1145,18 @@ public:
         return recover(std::move(etp)._executor, std::move(etp)._f);
     }
 
+    // Like recover, but f gets an expected<void>, so that an error can be handled without a throw
+    template <typename F>
+    auto then_expected(F&& f) const& {
+        return recover(detail::expected_continuation<void>(std::forward<F>(f)));
+    }
+
+    template <typename E, typename F>
+    auto then_expected(E&& executor, F&& f) const& {
+        return recover(std::forward<E>(executor),
+                       detail::expected_continuation<void>(std::forward<F>(f)));
+    }
+
     template <typename F>
     auto recover(F&& f) && {
         return _p->recover_r(unique_usage(_p), std::forward<F>(f));
@@ -964,6 +1177,17 @@ public:
         return std::move(*this).recover(std::move(etp)._executor, std::move(etp)._f);
     }
 
+    template <typename F>
+    auto then_expected(F&& f) && {
+        return std::move(*this).recover(detail::expected_continuation<void>(std::forward<F>(f)));
+    }
+
+    template <typename E, typename F>
+    auto then_expected(E&& executor, F&& f) && {
+        return std::move(*this).recover(std::forward<E>(executor),
+                                        detail::expected_continuation<void>(std::forward<F>(f)));
+    }
+
     void detach() const {
         (void)then([_hold = _p](auto) {}, []() {});
     }
@@ -1001,11 +1225,18 @@ class [[nodiscard]] future<T, enable_if_not_copyable<T>> {
         -> std::pair<detail::packaged_task_from_signature_t<Signature>,
                      future<detail::result_of_t_<Signature>>>;
 
-    friend struct detail::shared_base<T>;
+    template <typename, typename>
+    friend struct detail::shared_base;
 
     template <typename, typename>
     friend struct detail::value_;
 
+    template <typename U, typename E, typename F>
+    friend void detail::attach_continuation(const future<U>&, E, F&&);
+
+    template <typename R, typename E, typename F>
+    friend auto detail::package_deferred(E, F&&) -> future<R>;
+
 public:
     using result_type = T;
 
@@ -1062,6 +1293,18 @@ public:
         return std::move(*this).recover(std::move(etp)._executor, std::move(etp)._f);
     }
 
+    // Like recover, but f gets an expected<T>, so that an error can be handled without a throw
+    template <typename F>
+    auto then_expected(F&& f) && {
+        return std::move(*this).recover(detail::expected_continuation<T>(std::forward<F>(f)));
+    }
+
+    template <typename E, typename F>
+    auto then_expected(E&& executor, F&& f) && {
+        return std::move(*this).recover(std::forward<E>(executor),
+                                        detail::expected_continuation<T>(std::forward<F>(f)));
+    }
+
     void detach() const {
         (void)_p->then_r(unique_usage(_p), [_hold = _p](auto) {}, [](auto&&) {});
     }
@@ -1085,7 +1328,8 @@ public:
 template <typename Sig, typename E, typename F>
 auto package(E executor, F&& f)
     -> std::pair<detail::packaged_task_from_signature_t<Sig>, future<detail::result_of_t_<Sig>>> {
-    auto p = std::make_shared<detail::shared<Sig>>(std::move(executor), std::forward<F>(f));
+    auto p = std::make_shared<detail::shared<Sig, std::decay_t<F>>>(std::move(executor),
+                                                                  std::forward<F>(f));
     return std::make_pair(detail::packaged_task_from_signature_t<Sig>(p),
                           future<detail::result_of_t_<Sig>>(p));
 }
@@ -1093,12 +1337,13 @@ auto package(E executor, F&& f)
 template <typename Sig, typename E, typename F>
 auto package_with_broken_promise(E executor, F&& f)
     -> std::pair<detail::packaged_task_from_signature_t<Sig>, future<detail::result_of_t_<Sig>>> {
-    auto p = std::make_shared<detail::shared<Sig>>(std::move(executor), std::forward<F>(f));
+    auto p = std::make_shared<detail::shared<Sig, std::decay_t<F>>>(std::move(executor),
+                                                                  std::forward<F>(f));
     auto result = std::make_pair(detail::packaged_task_from_signature_t<Sig>(p),
                                  future<detail::result_of_t_<Sig>>(p));
     result.second._p->_exception =
         std::make_exception_ptr(future_error(future_error_codes::broken_promise));
-    result.second._p->_ready = true;
+    result.second._p->_state.set_ready();
     return result;
 }
 
@@ -1106,6 +1351,18 @@ auto package_with_broken_promise(E executor, F&& f)
 
 namespace detail {
 
+/*
+ * Calls f with x when x is ready. In contrast to recover no additional shared state is created.
+ * The continuation does not own x, so the caller has to keep x alive as long as f is of interest.
+ */
+template <typename T, typename E, typename F>
+void attach_continuation(const future<T>& x, E executor, F&& f) {
+    x._p->continue_with(std::move(executor), [_w = std::weak_ptr<shared_base<T>>(x._p),
+                                              _f = std::forward<F>(f)]() mutable {
+        if (auto p = _w.lock()) _f(future<T>(std::move(p)));
+    });
+}
+
 template <typename F>
 struct assign_ready_future {
     template <typename T>
@@ -1122,18 +1379,26 @@ struct assign_ready_future<future<void>> {
     }
 };
 
-template <typename F, typename Args>
+/*
+ * The shared state of the variadic combinators owns the arguments, and the continuations are
+ * attached directly to them. So the arguments are released, and by this canceled, as soon as the
+ * result is determined and the packaged task drops this state.
+ */
+template <typename F, typename Args, typename... Ts>
 struct when_all_shared {
     // decay
     Args _args;
-    future<void> _holds[std::tuple_size<Args>::value]{};
+    std::tuple<future<Ts>...> _holds;
     std::atomic_size_t _remaining{std::tuple_size<Args>::value};
     std::atomic_flag _error_happened = ATOMIC_FLAG_INIT;
     std::exception_ptr _exception;
     packaged_task<> _f;
 
+    explicit when_all_shared(future<Ts>... args) : _holds(std::move(args)...) {}
+
     template <std::size_t index, typename FF>
     void done(FF&& f) {
+        std::get<index>(_holds).reset(); // so that the value can be moved if f is the last owner
         assign_ready_future<FF>::assign(std::get<index>(_args), std::forward<FF>(f));
         if (--_remaining == 0) _f();
     }
@@ -1141,8 +1406,6 @@ struct when_all_shared {
     void failure(std::exception_ptr error) {
         auto before = _error_happened.test_and_set();
         if (before == false) {
-            for (auto& h : _holds)
-                h.reset();
             _exception = std::move(error);
             _f();
         }
@@ -1154,13 +1417,16 @@ struct when_any_shared {
     using result_type = R;
     // decay
     stlab::optional<R> _arg;
-    future<void> _holds[S]{};
+    std::array<future<R>, S> _holds;
     std::atomic_size_t _remaining{S};
     std::atomic_flag _value_received = ATOMIC_FLAG_INIT;
     std::exception_ptr _exception;
     size_t _index;
     packaged_task<> _f;
 
+    template <typename... Ts>
+    explicit when_any_shared(Ts... args) : _holds{{std::move(args)...}} {}
+
     void failure(std::exception_ptr error) {
         if (--_remaining == 0) {
             _exception = std::move(error);
@@ -1172,6 +1438,8 @@ struct when_any_shared {
     void done(FF&& f) {
         auto before = _value_received.test_and_set();
         if (before == false) {
+            // so that the value can be moved if f is the last owner
+            std::get<index>(_holds).reset();
             _arg = std::move(*std::forward<FF>(f).get_try());
             _index = index;
             _f();
@@ -1188,13 +1456,16 @@ template <size_t S>
 struct when_any_shared<S, void> {
     using result_type = void;
     // decay
-    future<void> _holds[S]{};
+    std::array<future<void>, S> _holds;
     std::atomic_size_t _remaining{S};
     std::atomic_flag _value_received = ATOMIC_FLAG_INIT;
     std::exception_ptr _exception;
     size_t _index;
     packaged_task<> _f;
 
+    template <typename... Ts>
+    explicit when_any_shared(Ts... args) : _holds{{std::move(args)...}} {}
+
     void failure(std::exception_ptr error) {
         if (--_remaining == 0) {
             _exception = std::move(error);
@@ -1245,9 +1516,9 @@ auto apply_when_any_arg(F& f, P& p) {
     return p->apply(f);
 }
 
-template <std::size_t i, typename E, typename P, typename T>
-void attach_when_arg_(E&& executor, std::shared_ptr<P>& p, T a) {
-    p->_holds[i] = std::move(a).recover(std::forward<E>(executor), [_w = std::weak_ptr<P>(p)](auto x) {
+template <std::size_t i, typename E, typename P>
+void attach_when_arg_(const E& executor, std::shared_ptr<P>& p) {
+    attach_continuation(std::get<i>(p->_holds), executor, [_w = std::weak_ptr<P>(p)](auto x) {
         auto p = _w.lock();
         if (!p) return;
 
@@ -1259,14 +1530,15 @@ void attach_when_arg_(E&& executor, std::shared_ptr<P>& p, T a) {
     });
 }
 
-template <typename E, typename P, typename... Ts, std::size_t... I>
-void attach_when_args_(std::index_sequence<I...>, E&& executor, std::shared_ptr<P>& p, Ts... a) {
-    (void)std::initializer_list<int>{(attach_when_arg_<I>(std::forward<E>(executor), p, std::move(a)), 0)...};
+template <typename E, typename P, std::size_t... I>
+void attach_when_args_(std::index_sequence<I...>, const E& executor, std::shared_ptr<P>& p) {
+    (void)std::initializer_list<int>{(attach_when_arg_<I>(executor, p), 0)...};
 }
 
-template <typename E, typename P, typename... Ts>
-void attach_when_args(E&& executor, std::shared_ptr<P>& p, Ts... a) {
-    attach_when_args_(std::make_index_sequence<sizeof...(Ts)>(), std::forward<E>(executor), p, std::move(a)...);
+template <typename E, typename P>
+void attach_when_args(const E& executor, std::shared_ptr<P>& p) {
+    attach_when_args_(std::make_index_sequence<std::tuple_size<decltype(p->_holds)>::value>(),
+                      executor, p);
 }
 
 } // namespace detail
@@ -1279,13 +1551,13 @@ auto when_all(E executor, F f, future<Ts>... args) {
     using opt_t = optional_placeholder_tuple<Ts...>;
     using result_t = decltype(detail::apply_tuple(std::declval<F>(), std::declval<vt_t>()));
 
-    auto shared = std::make_shared<detail::when_all_shared<F, opt_t>>();
+    auto shared = std::make_shared<detail::when_all_shared<F, opt_t, Ts...>>(std::move(args)...);
     auto p = package<result_t()>(executor, [_f = std::move(f), _p = shared] {
         return detail::apply_when_all_args(_f, _p);
     });
     shared->_f = std::move(p.first);
 
-    detail::attach_when_args(executor, shared, std::move(args)...);
+    detail::attach_when_args(executor, shared);
 
     return std::move(p.second);
 }
@@ -1298,13 +1570,14 @@ struct make_when_any {
     static auto make(E executor, F f, future<T> arg, future<Ts>... args) {
         using result_t = typename std::result_of<F(T, size_t)>::type;
 
-        auto shared = std::make_shared<detail::when_any_shared<sizeof...(Ts) + 1, T>>();
+        auto shared = std::make_shared<detail::when_any_shared<sizeof...(Ts) + 1, T>>(
+            std::move(arg), std::move(args)...);
         auto p = package<result_t()>(executor, [_f = std::move(f), _p = shared] {
             return detail::apply_when_any_arg(_f, _p);
         });
         shared->_f = std::move(p.first);
 
-        detail::attach_when_args(executor, shared, std::move(arg), std::move(args)...);
+        detail::attach_when_args(executor, shared);
 
         return std::move(p.second);
     }
@@ -1318,13 +1591,14 @@ struct make_when_any<void> {
     static auto make(E executor, F&& f, future<Ts>... args) {
         using result_t = typename std::result_of<F(size_t)>::type;
 
-        auto shared = std::make_shared<detail::when_any_shared<sizeof...(Ts), void>>();
+        auto shared =
+            std::make_shared<detail::when_any_shared<sizeof...(Ts), void>>(std::move(args)...);
         auto p = package<result_t()>(executor, [_f = std::forward<F>(f), _p = shared] {
             return detail::apply_when_any_arg(_f, _p);
         });
         shared->_f = std::move(p.first);
 
-        detail::attach_when_args(executor, shared, std::move(args)...);
+        detail::attach_when_args(executor, shared);
 
         return std::move(p.second);
     }
@@ -1445,16 +1719,14 @@ struct context_result<F, Indexed, void> {
 /*
  * This specialization is used for cases when only one ready future is enough to move forward.
  * In case of when_any, the first successfull future triggers the continuation. All others are
- * cancelled. In case of when_all, after the first error, this future cannot be fullfilled anymore
- * and so we cancel the all the others.
+ * cancelled when the context is released. In case of when_all, after the first error, this future
+ * cannot be fullfilled anymore and so we cancel the all the others.
  */
 struct single_trigger {
     template <typename C, typename F>
     static void go(C& context, F&& f, size_t index) {
         auto before = context._single_event_trigger.test_and_set();
         if (!before) {
-            for (auto& h : context._holds)
-                h.reset();
             context.apply(std::forward<F>(f), index);
             context._f();
         }
@@ -1483,14 +1755,132 @@ struct all_trigger {
     }
 };
 
-template <typename CR, typename F, typename ResultCollector, typename FailureCollector>
+/*
+ * This result is used by when_n. The first n successfully fulfilled futures are collected in the
+ * order of their arrival. The context fails as soon as more futures failed than can be tolerated
+ * to still reach the quorum of n.
+ */
+template <typename F, typename R>
+struct context_result_n {
+    using result_type = std::vector<R>;
+
+    std::vector<R> _results;
+    std::exception_ptr _exception;
+    std::atomic_size_t _received{0};
+    std::atomic_size_t _stored{0};
+    std::atomic_size_t _failed{0};
+    size_t _n;
+    size_t _tolerated;
+    F _f;
+
+    context_result_n(F f, size_t s, size_t n) : _n(n), _tolerated(s - n), _f(std::move(f)) {
+        _results.resize(n);
+    }
+
+    template <typename FF>
+    void store(FF&& f, size_t slot) {
+        _results[slot] = std::move(*std::forward<FF>(f).get_try());
+    }
+
+    auto operator()() { return _f(std::move(_results)); }
+};
+
+template <typename F>
+struct context_result_n<F, void> {
+    std::exception_ptr _exception;
+    std::atomic_size_t _received{0};
+    std::atomic_size_t _stored{0};
+    std::atomic_size_t _failed{0};
+    size_t _n;
+    size_t _tolerated;
+    F _f;
+
+    context_result_n(F f, size_t s, size_t n) : _n(n), _tolerated(s - n), _f(std::move(f)) {}
+
+    template <typename FF>
+    void store(FF&&, size_t) {}
+
+    auto operator()() { return _f(); }
+};
+
+template <typename R>
+struct empty_result_n {
+    template <typename F>
+    static auto go(F& f) {
+        return f(std::vector<R>{});
+    }
+};
+
+template <>
+struct empty_result_n<void> {
+    template <typename F>
+    static auto go(F& f) {
+        return f();
+    }
+};
+
+/*
+ * This specialization is used by when_n for the successfully fulfilled futures. Each value claims
+ * a slot in the result and the one that fills the last of the n slots triggers the continuation.
+ * All remaining futures are cancelled.
+ */
+struct quorum_trigger {
+    template <typename C, typename F>
+    static void go(C& context, F&& f, size_t) {
+        auto slot = context._received++;
+        if (slot >= context._n) return;
+        context.store(std::forward<F>(f), slot);
+        if (++context._stored != context._n) return;
+
+        auto before = context._single_event_trigger.test_and_set();
+        if (!before) {
+            context.release_holds();
+            context._f();
+        }
+    }
+};
+
+/*
+ * This specialization is used by when_n for the failed futures. As soon as the quorum cannot be
+ * reached anymore, the continuation is triggered with the last error and all remaining futures are
+ * cancelled.
+ */
+struct quorum_failure_trigger {
+    template <typename C>
+    static void go(C& context, std::exception_ptr error, size_t) {
+        if (++context._failed != context._tolerated + 1) return;
+
+        auto before = context._single_event_trigger.test_and_set();
+        if (!before) {
+            context.release_holds();
+            context._exception = std::move(error);
+            context._f();
+        }
+    }
+};
+
+/*
+ * The context owns the futures of the range and the continuations are attached directly to them,
+ * so no additional shared state per element is needed. A future is released as soon as it is
+ * ready and all remaining ones, and by this they are cancelled, when the result is determined and
+ * the packaged task drops the context. A trigger may release them earlier with release_holds().
+ */
+template <typename CR, typename F, typename ResultCollector, typename FailureCollector,
+          typename T>
 struct common_context : CR {
     std::atomic_size_t _remaining;
     std::atomic_flag _single_event_trigger = ATOMIC_FLAG_INIT;
-    std::vector<future<void>> _holds;
+    std::vector<future<T>> _holds;
     packaged_task<> _f;
+    std::mutex _holds_mutex;
+    bool _holds_attached{false};
+    bool _holds_released{false};
 
-    common_context(F f, size_t s) : CR(std::move(f), s), _remaining(s), _holds(_remaining) {}
+    template <typename... A>
+    common_context(F f, size_t s, A&&... a) :
+        CR(std::move(f), s, std::forward<A>(a)...), _remaining(s) {
+        _holds.reserve(s);
+    }
 
     auto execute() {
         if (this->_exception) {
@@ -1500,29 +1890,56 @@ struct common_context : CR {
     }
 
     void failure(std::exception_ptr& error, size_t index) {
+        release_hold(index);
         FailureCollector::go(*this, error, index);
     }
 
     template <typename FF>
     void done(FF&& f, size_t index) {
+        release_hold(index); // so that the value can be moved if f is the last owner
         ResultCollector::go(*this, std::forward<FF>(f), index);
     }
+
+    void release_hold(size_t index) {
+        future<T> hold;
+        std::unique_lock<std::mutex> lock(_holds_mutex);
+        if (index < _holds.size()) hold = std::move(_holds[index]);
+    }
+
+    /*
+        Releases, and by this cancels, all futures that are not ready yet. Attaching the
+        continuations reads the holds, so if that is still going on, holds_attached() releases
+        them afterwards.
+    */
+    void release_holds() {
+        std::vector<future<T>> holds;
+        std::unique_lock<std::mutex> lock(_holds_mutex);
+        _holds_released = true;
+        if (_holds_attached) holds.swap(_holds);
+    }
+
+    void holds_attached() {
+        std::vector<future<T>> holds;
+        std::unique_lock<std::mutex> lock(_holds_mutex);
+        _holds_attached = true;
+        if (_holds_released) holds.swap(_holds);
+    }
 };
 
 /**************************************************************************************************/
 
-template <typename C, typename E, typename T>
-void attach_tasks(size_t index, E executor, const std::shared_ptr<C>& context, T&& a) {
-    context->_holds[index] =
-        std::move(a).recover(std::move(executor), [_context = std::weak_ptr<C>(context), _i = index](auto x) {
-            auto p = _context.lock();
-            if (!p) return;
-            if (auto ex = x.exception(); ex) {
-                p->failure(ex, _i);
-            } else {
-                p->done(std::move(x), _i);
-            }
-        });
+template <typename C, typename E>
+void attach_tasks(size_t index, const E& executor, const std::shared_ptr<C>& context) {
+    attach_continuation(context->_holds[index], executor,
+                        [_context = std::weak_ptr<C>(context), _i = index](auto x) {
+                            auto p = _context.lock();
+                            if (!p) return;
+                            if (auto ex = x.exception(); ex) {
+                                p->failure(ex, _i);
+                            } else {
+                                p->done(std::move(x), _i);
+                            }
+                        });
 }
 
 template <typename R, typename T, typename C, typename Enabled = void>
@@ -1531,19 +1948,22 @@ struct create_range_of_futures;
 template <typename R, typename T, typename C>
 struct create_range_of_futures<R, T, C, enable_if_copyable<T>> {
 
-    template <typename E, typename F, typename I>
-    static auto do_it(E executor, F&& f, I first, I last) {
+    template <typename E, typename F, typename I, typename... A>
+    static auto do_it(E executor, F&& f, I first, I last, A&&... a) {
         assert(first != last);
 
-        auto context = std::make_shared<C>(std::forward<F>(f), std::distance(first, last));
+        auto context = std::make_shared<C>(std::forward<F>(f), std::distance(first, last),
+                                           std::forward<A>(a)...);
         auto p = package<R()>(executor, [_c = context]() mutable { return _c->execute(); });
 
         context->_f = std::move(p.first);
 
-        size_t index(0);
-        for (; first != last; ++first) {
-            attach_tasks(index++, executor, context, *first);
+        // All futures must be owned by the context before the first continuation may run
+        context->_holds.assign(first, last);
+        for (size_t index = 0, size = context->_holds.size(); index != size; ++index) {
+            attach_tasks(index, executor, context);
         }
+        context->holds_attached();
 
         return std::move(p.second);
     }
@@ -1552,19 +1972,22 @@ struct create_range_of_futures<R, T, C, enable_if_copyable<T>> {
 template <typename R, typename T, typename C>
 struct create_range_of_futures<R, T, C, enable_if_not_copyable<T>> {
 
-    template <typename E, typename F, typename I>
-    static auto do_it(E executor, F&& f, I first, I last) {
+    template <typename E, typename F, typename I, typename... A>
+    static auto do_it(E executor, F&& f, I first, I last, A&&... a) {
         assert(first != last);
 
-        auto context = std::make_shared<C>(std::forward<F>(f), std::distance(first, last));
+        auto context = std::make_shared<C>(std::forward<F>(f), std::distance(first, last),
+                                           std::forward<A>(a)...);
         auto p = package<R()>(executor, [_c = context] { return _c->execute(); });
 
         context->_f = std::move(p.first);
 
-        size_t index(0);
-        for (; first != last; ++first) {
-            attach_tasks(index++, executor, context, std::forward<decltype(*first)>(*first));
+        // All futures must be owned by the context before the first continuation may run
+        context->_holds.assign(std::make_move_iterator(first), std::make_move_iterator(last));
+        for (size_t index = 0, size = context->_holds.size(); index != size; ++index) {
+            attach_tasks(index, executor, context);
         }
+        context->holds_attached();
 
         return std::move(p.second);
     }
@@ -1586,7 +2009,7 @@ auto when_all(E executor, F f, std::pair<I, I> range) {
     using context_result_t =
         std::conditional_t<std::is_same<void, param_t>::value, void, std::vector<param_t>>;
     using context_t = detail::common_context<detail::context_result<F, false, context_result_t>, F,
-                                             detail::all_trigger, detail::single_trigger>;
+                                             detail::all_trigger, detail::single_trigger, param_t>;
 
     if (range.first == range.second) {
         auto p = package<result_t()>(
@@ -1610,7 +2033,7 @@ auto when_any(E executor, F&& f, std::pair<I, I> range) {
     using result_t = typename detail::result_of_when_any_t<F, param_t>::result_type;
     using context_result_t = std::conditional_t<std::is_same<void, param_t>::value, void, param_t>;
     using context_t = detail::common_context<detail::context_result<F, true, context_result_t>, F,
-                                             detail::single_trigger, detail::all_trigger>;
+                                             detail::single_trigger, detail::all_trigger, param_t>;
 
     if (range.first == range.second) {
         auto p = package_with_broken_promise<result_t()>(
@@ -1625,6 +2048,62 @@ auto when_any(E executor, F&& f, std::pair<I, I> range) {
 
 /**************************************************************************************************/
 
+/*
+ * when_n triggers the continuation as soon as n of the given futures are fulfilled. The
+ * continuation gets the values in the order of their arrival. All other futures are cancelled. If
+ * so many futures fail that n cannot be reached anymore, the resulting future fails with the last
+ * error.
+ */
+template <
+    typename E, // models task executor
+    typename F, // models functional object
+    typename I> // models ForwardIterator that reference to a range of futures of the same type
+auto when_n(E executor, F f, size_t n, std::pair<I, I> range) {
+    using param_t = typename std::iterator_traits<I>::value_type::result_type;
+    using result_t = typename detail::result_of_when_n_t<F, param_t>::result_type;
+    using context_t = detail::common_context<detail::context_result_n<F, param_t>, F,
+                                             detail::quorum_trigger,
+                                             detail::quorum_failure_trigger, param_t>;
+
+    const auto size = static_cast<size_t>(std::distance(range.first, range.second));
+
+    if (size < n) {
+        auto p = package_with_broken_promise<result_t()>(
+            std::move(executor),
+            [_f = std::move(f)]() mutable { return detail::empty_result_n<param_t>::go(_f); });
+        return std::move(p.second);
+    }
+
+    if (n == 0) {
+        auto p = package<result_t()>(executor, [_f = std::move(f)]() mutable {
+            return detail::empty_result_n<param_t>::go(_f);
+        });
+        executor(std::move(p.first));
+        return std::move(p.second);
+    }
+
+    return detail::create_range_of_futures<result_t, param_t, context_t>::do_it(
+        std::move(executor), std::move(f), range.first, range.second, n);
+}
+
+/**************************************************************************************************/
+
+template <typename E, typename F, typename T, typename... Ts>
+auto when_n(E executor, F f, size_t n, future<T> arg, future<Ts>... args) {
+    static_assert(std::conjunction<std::is_same<T, Ts>...>::value,
+                  "when_n requires futures of the same type");
+
+    std::vector<future<T>> futures;
+    futures.reserve(sizeof...(Ts) + 1);
+    futures.push_back(std::move(arg));
+    (void)std::initializer_list<int>{(futures.push_back(std::move(args)), 0)...};
+
+    return when_n(std::move(executor), std::move(f), n,
+                  std::make_pair(futures.begin(), futures.end()));
+}
+
+/**************************************************************************************************/
+
 template <typename E, typename F, typename... Args>
 auto async(E executor, F&& f, Args&&... args)
     -> future<std::result_of_t<std::decay_t<F>(std::decay_t<Args>...)>> {
@@ -1647,29 +2126,55 @@ auto async(E executor, F&& f, Args&&... args)
 
 namespace detail {
 
-template <typename T>
-struct reduction_helper {};
+/*
+ * The packaged task of a deferred future is stored as its only continuation and the state is
+ * marked as deferred. The first continuation that is attached takes it out and passes it to the
+ * executor. If the future is destructed before, the packaged task is destructed with the state and
+ * never runs.
+ */
+template <typename R, typename E, typename F>
+auto package_deferred(E executor, F&& f) -> future<R> {
+    auto p = package<R()>(executor, std::forward<F>(f));
+    p.second._p->continue_with(std::move(executor), std::move(p.first));
+    p.second._p->_state.set_deferred();
+    return std::move(p.second);
+}
 
-template <typename T>
-struct reduction_helper<future<T>> {
-    future<void> value;
-};
+} // namespace detail
 
-template <>
-struct reduction_helper<future<void>> {
-    future<void> value;
-};
+/*
+ * lazy_async() is like async(), but the function is passed to the executor only when the returned
+ * future is observed, that is when the first continuation is attached, e.g. by then(), recover(),
+ * when_all(), when_any() or blocking_get(). If the future is destructed before, the function never
+ * runs. Polling with get_try() does not start it.
+ */
+template <typename E, typename F, typename... Args>
+auto lazy_async(E executor, F&& f, Args&&... args)
+    -> future<std::result_of_t<std::decay_t<F>(std::decay_t<Args>...)>> {
+    using result_type = std::result_of_t<std::decay_t<F>(std::decay_t<Args>...)>;
+
+    return detail::package_deferred<result_type>(
+        std::move(executor),
+        std::bind<result_type>(
+            [_f = std::forward<F>(f)](
+                unwrap_reference_t<std::decay_t<Args>>&... args) mutable -> result_type {
+                return _f(move_if<!is_reference_wrapper_v<std::decay_t<Args>>>(args)...);
+            },
+            std::forward<Args>(args)...));
+}
 
 /**************************************************************************************************/
 
+namespace detail {
+
 template <typename T>
 struct value_<T, enable_if_copyable<T>> {
     template <typename C>
     static void proceed(C& sb) {
         typename C::then_t then;
         {
-            std::unique_lock<std::mutex> lock(sb._mutex);
-            sb._ready = true;
+            std::unique_lock<state_word> lock(sb._state);
+            sb._state.set_ready();
             then = std::move(sb._then);
         }
         for (auto& e : then)
@@ -1682,36 +2187,18 @@ struct value_<T, enable_if_copyable<T>> {
         proceed(sb);
     }
 
+    // A nested future becomes ready together with the inner one and takes over its error
     template <typename R, typename F, typename... Args>
     static void set(shared_base<future<R>>& sb, F& f, Args&&... args) {
         sb._result = f(std::forward<Args>(args)...);
-        sb._reduction_helper.value =
-            (*sb._result)
-                .recover([_p = sb.shared_from_this()](future<R> f) {
-                    if (f.exception()) {
-                        _p->_exception = std::move(f).exception();
-                        proceed(*_p);
-                        throw future_error(future_error_codes::reduction_failed);
-                    }
-                    return *f.get_try();
-                })
-                .then([_p = sb.shared_from_this()](auto) { proceed(*_p); });
-    }
-
-    template <typename F, typename... Args>
-    static void set(shared_base<future<void>>& sb, F& f, Args&&... args) {
-        sb._result = f(std::forward<Args>(args)...);
-        sb._reduction_helper.value =
-            (*sb._result)
-                .recover([_p = sb.shared_from_this()](future<void> f) {
-                     if (f.exception()) {
-                         _p->_exception = std::move(f).exception();
-                         value_::proceed(*_p);
-                         throw future_error(future_error_codes::reduction_failed);
-                     }
-                     return;
-                 })
-                 .then([_p = sb.shared_from_this()]() { proceed(*_p); });
+        attach_continuation(*sb._result, immediate_executor,
+                            [_w = std::weak_ptr<shared_base<future<R>>>(sb.shared_from_this())](
+                                const auto& x) {
+                                auto p = _w.lock();
+                                if (!p) return;
+                                p->_exception = x.exception();
+                                proceed(*p);
+                            });
     }
 };
 
@@ -1721,8 +2208,8 @@ struct value_<T, enable_if_not_copyable<T>> {
     static void proceed(C& sb) {
         typename C::then_t then;
         {
-            std::unique_lock<std::mutex> lock(sb._mutex);
-            sb._ready = true;
+            std::unique_lock<state_word> lock(sb._state);
+            sb._state.set_ready();
             then = std::move(sb._then);
         }
         if (then.first) then.first(std::move(then.second));
@@ -1737,17 +2224,14 @@ struct value_<T, enable_if_not_copyable<T>> {
     template <typename R, typename F, typename... Args>
     static void set(shared_base<future<R>>& sb, F& f, Args&&... args) {
         sb._result = f(std::forward<Args>(args)...);
-        sb._reduction_helper.value =
-            std::move(*sb._result)
-                .recover([_p = sb.shared_from_this()](future<R> f) {
-                    if (auto ex = std::move(f).exception(); ex) {
-                        _p->_exception = ex;
-                        proceed(*_p);
-                        throw future_error(future_error_codes::reduction_failed);
-                    }
-                    return *f.get_try();
-                })
-                .then([_p = sb.shared_from_this()](auto) { proceed(*_p); });
+        attach_continuation(*sb._result, immediate_executor,
+                            [_w = std::weak_ptr<shared_base<future<R>>>(sb.shared_from_this())](
+                                const auto& x) {
+                                auto p = _w.lock();
+                                if (!p) return;
+                                p->_exception = x.exception();
+                                proceed(*p);
+                            });
     }
 };
 
@@ -1757,8 +2241,8 @@ struct value_<void> {
     static void proceed(C& sb) {
         typename C::then_t then;
         {
-            std::unique_lock<std::mutex> lock(sb._mutex);
-            sb._ready = true;
+            std::unique_lock<state_word> lock(sb._state);
+            sb._state.set_ready();
             then = std::move(sb._then);
         }
         for (auto& e : then)
@@ -1794,59 +2278,123 @@ void shared_base<void>::set_value(F& f, Args&&... args) {
 /**************************************************************************************************/
 
 template <typename E, typename F>
-auto shared_base<void>::recover(E&& executor, F&& f)
+auto shared_base<void>::recover(E&& executor, F&& f, bool forward_error)
     -> future<reduced_t<std::result_of_t<F(future<void>)>>> {
     auto p = package<std::result_of_t<F(future<void>)>()>(
         executor, [_f = std::forward<F>(f), _p = future<void>(this->shared_from_this())]() mutable {
             return _f(_p);
         });
 
-    bool ready;
-    {
-        std::unique_lock<std::mutex> lock(_mutex);
-        ready = _ready;
-        if (!ready) _then.emplace_back(std::forward<E>(executor), std::move(p.first));
-    }
-    if (ready) executor(std::move(p.first));
+    continue_with(std::forward<E>(executor),
+                  continuation_task(this->shared_from_this(), std::move(p.first), forward_error));
 
     return reduce(std::move(p.second));
 }
 
 /**************************************************************************************************/
 
+/*
+ * owning_promise<R>::make(executor, hold) packages the promise of an operation whose future owns
+ * hold, usually the shared state of the operation. The pending parts of the operation only keep
+ * weak references to that state, so dropping the future destroys it and cancels them.
+ * fulfill(p, f) sets the value of the ready future f.
+ */
+template <typename R>
+struct owning_promise {
+    using task_type = packaged_task<R>;
+
+    template <typename E, typename H>
+    static auto make(E executor, H hold) {
+        return package<R(R)>(std::move(executor), [_hold = std::move(hold)](auto&& x) {
+            return std::forward<decltype(x)>(x);
+        });
+    }
+
+    template <typename F>
+    static void fulfill(const task_type& p, F&& f) {
+        p(std::move(*std::move(f).get_try()));
+    }
+};
+
+template <>
+struct owning_promise<void> {
+    using task_type = packaged_task<>;
+
+    template <typename E, typename H>
+    static auto make(E executor, H hold) {
+        return package<void()>(std::move(executor), [_hold = std::move(hold)] {});
+    }
+
+    template <typename F>
+    static void fulfill(const task_type& p, F&&) {
+        p();
+    }
+};
+
+/*
+ * The result of a continuation that returns a future is fulfilled directly by the inner future,
+ * without scheduling a further continuation. The result owns the nested future and releases it as
+ * soon as the value is forwarded.
+ */
+template <typename R, typename N>
+auto reduce_nested(std::shared_ptr<shared_base<future<R>>> nested, N&& r) -> future<R> {
+    auto p = owning_promise<R>::make(nested->_executor, std::forward<N>(r));
+
+    nested->continue_with(immediate_executor, [_w = std::weak_ptr<shared_base<future<R>>>(nested),
+                                               _p = std::move(p.first)] {
+        auto nested = _w.lock();
+        if (!nested) return;
+        if (nested->_exception) {
+            _p.set_exception(nested->_exception);
+            return;
+        }
+        owning_promise<R>::fulfill(_p, *nested->_result);
+    });
+
+    return std::move(p.second);
+}
+
+/**************************************************************************************************/
+
 template <typename T>
 auto shared_base<T, enable_if_copyable<T>>::reduce(future<future<void>>&& r) -> future<void> {
-    return std::move(r).then([](auto) {});
+    auto nested = r._p;
+    return reduce_nested(std::move(nested), std::move(r));
 }
 
 template <typename T>
 template <typename R>
 auto shared_base<T, enable_if_copyable<T>>::reduce(future<future<R>>&& r) -> future<R> {
-    return std::move(r).then([](auto&& f) { return *std::forward<decltype(f)>(f).get_try(); });
+    auto nested = r._p;
+    return reduce_nested(std::move(nested), std::move(r));
 }
 
 /**************************************************************************************************/
 
 template <typename T>
 auto shared_base<T, enable_if_not_copyable<T>>::reduce(future<future<void>>&& r) -> future<void> {
-    return std::move(r).then([](auto){});
+    auto nested = r._p;
+    return reduce_nested(std::move(nested), std::move(r));
 }
 
 template <typename T>
 template <typename R>
 auto shared_base<T, enable_if_not_copyable<T>>::reduce(future<future<R>>&& r) -> future<R> {
-    return std::move(r).then([](auto&& f) { return *std::forward<decltype(f)>(f).get_try(); });
+    auto nested = r._p;
+    return reduce_nested(std::move(nested), std::move(r));
 }
 
 /**************************************************************************************************/
 
 inline auto shared_base<void>::reduce(future<future<void>>&& r) -> future<void> {
-    return std::move(r).then([](auto) {});
+    auto nested = r._p;
+    return reduce_nested(std::move(nested), std::move(r));
 }
 
 template <typename R>
 auto shared_base<void>::reduce(future<future<R>>&& r) -> future<R> {
-    return std::move(r).then([](auto&& f) { return *std::forward<decltype(f)>(f).get_try(); });
+    auto nested = r._p;
+    return reduce_nested(std::move(nested), std::move(r));
 }
 
 /**************************************************************************************************/
@@ -1865,8 +2413,90 @@ auto shared_base<void>::reduce(future<future<R>>&& r) -> future<R> {
 
 #if STLAB_FUTURE_COROUTINES_SUPPORT() == 1
 
+namespace stlab {
+inline namespace v1 {
+namespace detail {
+
+#if STLAB_FUTURE_COROUTINES_PRIVATE_STD()
+namespace coro = std;
+#else
+namespace coro = std::experimental;
+#endif
+
+/**************************************************************************************************/
+
+/*
+ * Awaiting a future attaches the resumption of the coroutine directly to the shared state of the
+ * future, so the coroutine is resumed on the thread that fulfills it, without a continuation
+ * future and without a hop through an executor. If the future gets ready while the continuation
+ * is attached, the coroutine is not suspended at all. Use schedule_on() to continue on a
+ * particular executor.
+ */
+template <typename R>
+class future_awaiter {
+    future<R> _input;
+    stlab::optional<expected<R>> _result;
+    std::atomic_bool _handoff{false};
+    coro::coroutine_handle<> _handle;
+
+public:
+    explicit future_awaiter(future<R> input) : _input(std::move(input)) {}
+
+    bool await_ready() const { return _input.is_ready(); }
+
+    bool await_suspend(coro::coroutine_handle<> handle) {
+        _handle = handle;
+        attach_continuation(_input, immediate_executor, [this](auto&& x) {
+            _result = make_expected<R>::go(std::forward<decltype(x)>(x));
+            // Whoever comes second, this continuation or await_suspend, continues the coroutine
+            if (_handoff.exchange(true)) _handle.resume();
+        });
+        return !_handoff.exchange(true);
+    }
+
+    R await_resume() {
+        if (!_result) _result = make_expected<R>::go(std::move(_input));
+        return std::move(*_result).value();
+    }
+};
+
+template <typename E>
+struct schedule_awaiter {
+    E _executor;
+
+    bool await_ready() const { return false; }
+
+    void await_suspend(coro::coroutine_handle<> handle) {
+        _executor([handle]() mutable { handle.resume(); });
+    }
+
+    void await_resume() const {}
+};
+
+} // namespace detail
+
+/**************************************************************************************************/
+
+template <typename R>
+auto operator co_await(future<R> x) {
+    return detail::future_awaiter<R>(std::move(x));
+}
+
+/*
+ * co_await schedule_on(executor) suspends the coroutine and resumes it as a task on executor.
+ */
+template <typename E>
+auto schedule_on(E executor) {
+    return detail::schedule_awaiter<E>{std::move(executor)};
+}
+
+} // namespace v1
+} // namespace stlab
+
+/**************************************************************************************************/
+
 template <typename T, typename... Args>
-struct std::experimental::coroutine_traits<stlab::future<T>, Args...> {
+struct stlab::detail::coro::coroutine_traits<stlab::future<T>, Args...> {
     struct promise_type {
         std::pair<stlab::packaged_task<T>, stlab::future<T>> _promise;
 
@@ -1878,9 +2508,9 @@ struct std::experimental::coroutine_traits<stlab::future<T>, Args...> {
 
         stlab::future<T> get_return_object() { return std::move(_promise.second); }
 
-        auto initial_suspend() const { return std::experimental::suspend_never{}; }
+        auto initial_suspend() const noexcept { return stlab::detail::coro::suspend_never{}; }
 
-        auto final_suspend() const { return std::experimental::suspend_never{}; }
+        auto final_suspend() const noexcept { return stlab::detail::coro::suspend_never{}; }
 
         template <typename U>
         void return_value(U&& val) {
@@ -1892,7 +2522,7 @@ struct std::experimental::coroutine_traits<stlab::future<T>, Args...> {
 };
 
 template <typename... Args>
-struct std::experimental::coroutine_traits<stlab::future<void>, Args...> {
+struct stlab::detail::coro::coroutine_traits<stlab::future<void>, Args...> {
     struct promise_type {
         std::pair<stlab::packaged_task<>, stlab::future<void>> _promise;
 
@@ -1902,9 +2532,11 @@ struct std::experimental::coroutine_traits<stlab::future<void>, Args...> {
 
         inline stlab::future<void> get_return_object() { return _promise.second; }
 
-        inline auto initial_suspend() const { return std::experimental::suspend_never{}; }
+        inline auto initial_suspend() const noexcept {
+            return stlab::detail::coro::suspend_never{};
+        }
 
-        inline auto final_suspend() const { return std::experimental::suspend_never{}; }
+        inline auto final_suspend() const noexcept { return stlab::detail::coro::suspend_never{}; }
 
         inline void return_void() { _promise.first(); }
 
@@ -1914,46 +2546,6 @@ struct std::experimental::coroutine_traits<stlab::future<void>, Args...> {
     };
 };
 
-template <typename R>
-auto operator co_await(stlab::future<R> f) {
-    struct Awaiter {
-        stlab::future<R> _input;
-        R _result;
-
-        bool await_ready() { return _input.is_ready(); }
-
-        auto await_resume() { return std::move(_result); }
-
-        void await_suspend(std::experimental::coroutine_handle<> ch) {
-            std::move(_input)
-                .then(stlab::default_executor,
-                      [this, ch](auto&& result) mutable {
-                          this->_result = std::forward<decltype(result)>(result);
-                          ch.resume();
-                      })
-                .detach();
-        }
-    };
-    return Awaiter{std::move(f)};
-}
-
-inline auto operator co_await(stlab::future<void> f) {
-    struct Awaiter {
-        stlab::future<void> _input;
-
-        inline bool await_ready() { return _input.is_ready(); }
-
-        inline auto await_resume() {}
-
-        inline void await_suspend(std::experimental::coroutine_handle<> ch) {
-            std::move(_input)
-                .then(stlab::default_executor, [ch]() mutable { ch.resume(); })
-                .detach();
-        }
-    };
-    return Awaiter{std::move(f)};
-}
-
 #endif
 
 #endif
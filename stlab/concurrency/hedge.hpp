@@ -0,0 +1,207 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#ifndef STLAB_CONCURRENCY_HEDGE_HPP
+#define STLAB_CONCURRENCY_HEDGE_HPP
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+#include <stlab/concurrency/system_timer.hpp>
+
+#include <stlab/memory.hpp>
+
+/**************************************************************************************************/
+
+namespace stlab {
+
+/**************************************************************************************************/
+
+inline namespace v1 {
+
+/**************************************************************************************************/
+
+/*
+ * Counters of a hedged request. _attempts is the number of started attempts and _winner the
+ * zero based index of the attempt that delivered the result.
+ */
+struct hedge_statistics {
+    std::atomic_size_t _attempts{0};
+    std::atomic_size_t _winner{0};
+};
+
+/**************************************************************************************************/
+
+namespace detail {
+
+/**************************************************************************************************/
+
+template <typename T, typename E, typename F, typename D>
+struct hedge_shared : std::enable_shared_from_this<hedge_shared<T, E, F, D>> {
+    std::mutex _mutex;
+    E _executor;
+    D _delay;
+    F _factory;
+    std::size_t _max_attempts;
+    std::size_t _started{0};
+    std::size_t _failed{0};
+    bool _done{false};
+    std::vector<future<void>> _holds;
+    std::shared_ptr<hedge_statistics> _statistics;
+    typename owning_promise<T>::task_type _promise;
+
+    hedge_shared(E executor,
+                 D delay,
+                 F factory,
+                 std::size_t max_attempts,
+                 std::shared_ptr<hedge_statistics> statistics) :
+        _executor(std::move(executor)), _delay(delay), _factory(std::move(factory)),
+        _max_attempts(max_attempts), _statistics(std::move(statistics)) {
+        _holds.reserve(max_attempts);
+    }
+
+    /*
+        Starts the next attempt if exactly started attempts were started so far. The timer of an
+        attempt is ignored if a failure started another attempt in the meantime, so the next attempt
+        always follows the delay after the latest one.
+    */
+    void launch(std::size_t started) {
+        std::size_t index;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_done || _started == _max_attempts || _started != started) return;
+            index = _started++;
+        }
+        if (_statistics) ++_statistics->_attempts;
+
+        future<T> attempt;
+        try {
+            attempt = _factory();
+        } catch (...) {
+            failure(std::current_exception());
+            return;
+        }
+
+        auto hold = std::move(attempt).recover(
+            immediate_executor, [_w = make_weak_ptr(this->shared_from_this()), index](auto&& x) {
+                auto p = _w.lock();
+                if (!p) return;
+                p->complete(index, std::forward<decltype(x)>(x));
+            });
+
+        bool schedule;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (!_done) _holds.push_back(std::move(hold));
+            schedule = !_done && _started != _max_attempts;
+        }
+        if (!schedule) return;
+
+        // The next attempt is only started when this one has not answered within the delay
+        stlab::system_timer(_delay, [_w = make_weak_ptr(this->shared_from_this()), index] {
+            auto p = _w.lock();
+            if (!p) return;
+            p->_executor([_w = std::move(_w), index] {
+                auto p = _w.lock();
+                if (p) p->launch(index + 1);
+            });
+        });
+    }
+
+    template <typename FF>
+    void complete(std::size_t index, FF&& f) {
+        if (auto ex = f.exception(); ex) {
+            failure(std::move(ex));
+            return;
+        }
+        std::vector<future<void>> losers;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_done) return;
+            _done = true;
+            losers = std::move(_holds);
+        }
+        if (_statistics) _statistics->_winner = index;
+        owning_promise<T>::fulfill(_promise, std::forward<FF>(f));
+    }
+
+    /*
+        Counts a failed attempt, either one whose future failed or one whose factory threw. A
+        failed attempt cannot answer anymore, so the next one is started without delay.
+    */
+    void failure(std::exception_ptr error) {
+        std::vector<future<void>> losers;
+        bool failed;
+        std::size_t started;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_done) return;
+            failed = ++_failed == _max_attempts;
+            _done = failed;
+            if (failed) losers = std::move(_holds);
+            started = _started;
+        }
+        if (failed)
+            _promise.set_exception(std::move(error));
+        else
+            launch(started);
+    }
+};
+
+/**************************************************************************************************/
+
+} // namespace detail
+
+/**************************************************************************************************/
+
+/*
+ * hedge starts a first attempt by calling factory and each delay without an answer one more
+ * attempt, up to max_attempts. The resulting future is fulfilled by the first attempt that
+ * succeeds; the other attempts are dropped so that they get cancelled. A factory that throws counts
+ * as a failed attempt. The result fails with the error of the last attempt if all attempts failed.
+ */
+template <typename E, typename Rep, typename Per, typename F>
+auto hedge(E executor,
+           std::chrono::duration<Rep, Per> delay,
+           F factory,
+           std::size_t max_attempts,
+           std::shared_ptr<hedge_statistics> statistics = {}) {
+    using result_t = typename std::result_of_t<F()>::result_type;
+    using shared_t = detail::hedge_shared<result_t, E, F, std::chrono::duration<Rep, Per>>;
+    assert(max_attempts > 0);
+
+    auto shared = std::make_shared<shared_t>(executor, delay, std::move(factory), max_attempts,
+                                             std::move(statistics));
+
+    auto p = detail::owning_promise<result_t>::make(std::move(executor), shared);
+    shared->_promise = std::move(p.first);
+    shared->launch(0);
+
+    return std::move(p.second);
+}
+
+/**************************************************************************************************/
+
+} // namespace v1
+
+/**************************************************************************************************/
+
+} // namespace stlab
+
+/**************************************************************************************************/
+
+#endif // STLAB_CONCURRENCY_HEDGE_HPP
+
+/**************************************************************************************************/
@@ -0,0 +1,310 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#ifndef STLAB_CONCURRENCY_LAZY_TASK_HPP
+#define STLAB_CONCURRENCY_LAZY_TASK_HPP
+
+#include <array>
+#include <cstddef>
+#include <exception>
+#include <new>
+#include <utility>
+
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/optional.hpp>
+
+#if STLAB_FUTURE_COROUTINES_SUPPORT() == 1
+
+/**************************************************************************************************/
+
+namespace stlab {
+
+/**************************************************************************************************/
+
+inline namespace v1 {
+
+/**************************************************************************************************/
+
+template <typename T = void>
+class lazy_task;
+
+/**************************************************************************************************/
+
+namespace detail {
+
+/**************************************************************************************************/
+
+/*
+ * frame_pool recycles coroutine frames per thread. Frames are rounded up to multiples of 64 bytes
+ * and up to 64 freed frames of each size up to 1 KiB are kept for reuse. Larger frames are passed
+ * to the global operator new. A frame may be freed on another thread than it was allocated on; it
+ * is then cached by that thread. A frame that is freed during thread exit, after the pool of the
+ * thread is destroyed, is passed to the global operator delete.
+ */
+class frame_pool {
+    static constexpr std::size_t granularity = 64;
+    static constexpr std::size_t size_classes = 16;
+    static constexpr std::size_t max_cached = 64;
+
+    struct node {
+        node* _next;
+    };
+
+    std::array<node*, size_classes> _free{};
+    std::array<std::size_t, size_classes> _cached{};
+
+    static std::size_t size_class(std::size_t size) {
+        return (size + granularity - 1) / granularity;
+    }
+
+    // A trivially destructible thread_local stays valid after the pool of the thread is destroyed
+    static bool& destroyed_() {
+        thread_local bool result = false;
+        return result;
+    }
+
+public:
+    frame_pool() = default;
+    frame_pool(const frame_pool&) = delete;
+    frame_pool& operator=(const frame_pool&) = delete;
+
+    ~frame_pool() {
+        destroyed_() = true;
+        for (auto head : _free) {
+            while (head) {
+                auto next = head->_next;
+                ::operator delete(head);
+                head = next;
+            }
+        }
+    }
+
+    static frame_pool& local() {
+        thread_local frame_pool pool;
+        return pool;
+    }
+
+    static bool destroyed() { return destroyed_(); }
+
+    static void* allocate_local(std::size_t size) {
+        return destroyed() ? ::operator new(size) : local().allocate(size);
+    }
+
+    static void deallocate_local(void* p, std::size_t size) {
+        if (destroyed())
+            ::operator delete(p);
+        else
+            local().deallocate(p, size);
+    }
+
+    void* allocate(std::size_t size) {
+        const auto c = size_class(size);
+        if (c == 0 || c > size_classes) return ::operator new(size);
+
+        auto& head = _free[c - 1];
+        if (!head) return ::operator new(c * granularity);
+
+        auto result = head;
+        head = result->_next;
+        --_cached[c - 1];
+        return result;
+    }
+
+    void deallocate(void* p, std::size_t size) {
+        const auto c = size_class(size);
+        if (c == 0 || c > size_classes || _cached[c - 1] == max_cached) {
+            ::operator delete(p);
+            return;
+        }
+
+        auto n = static_cast<node*>(p);
+        n->_next = _free[c - 1];
+        _free[c - 1] = n;
+        ++_cached[c - 1];
+    }
+
+    std::size_t cached(std::size_t size) const {
+        const auto c = size_class(size);
+        return c == 0 || c > size_classes ? 0 : _cached[c - 1];
+    }
+};
+
+/**************************************************************************************************/
+
+struct lazy_promise_base {
+    coro::coroutine_handle<> _continuation;
+    std::exception_ptr _error;
+
+    static void* operator new(std::size_t size) { return frame_pool::allocate_local(size); }
+
+    static void operator delete(void* p, std::size_t size) {
+        frame_pool::deallocate_local(p, size);
+    }
+
+    coro::suspend_always initial_suspend() const noexcept { return {}; }
+
+    // The finished coroutine continues its awaiting coroutine by symmetric transfer, so a chain of
+    // awaited lazy tasks that finish synchronously does not grow the stack.
+    struct final_awaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template <typename P>
+        coro::coroutine_handle<> await_suspend(coro::coroutine_handle<P> handle) noexcept {
+            auto continuation = handle.promise()._continuation;
+            if (continuation) return continuation;
+            return coro::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    final_awaiter final_suspend() const noexcept { return {}; }
+
+    void unhandled_exception() { _error = std::current_exception(); }
+};
+
+template <typename T>
+struct lazy_promise : lazy_promise_base {
+    stlab::optional<T> _value;
+
+    lazy_task<T> get_return_object();
+
+    template <typename U>
+    void return_value(U&& x) {
+        _value = std::forward<U>(x);
+    }
+
+    T result() {
+        if (_error) std::rethrow_exception(_error);
+        return std::move(*_value);
+    }
+};
+
+template <>
+struct lazy_promise<void> : lazy_promise_base {
+    lazy_task<void> get_return_object();
+
+    void return_void() const {}
+
+    void result() const {
+        if (_error) std::rethrow_exception(_error);
+    }
+};
+
+/**************************************************************************************************/
+
+} // namespace detail
+
+/**************************************************************************************************/
+
+/*
+ * lazy_task is a move only coroutine type that starts only when it is awaited. An awaiting
+ * coroutine transfers control to it directly and it transfers back when it is finished, so there
+ * is no shared state and no executor involved. The frames are allocated from a per thread
+ * recycling pool. to_future() starts a lazy_task and returns a future, it creates a shared state
+ * only then.
+ */
+template <typename T>
+class [[nodiscard]] lazy_task {
+public:
+    using promise_type = detail::lazy_promise<T>;
+    using result_type = T;
+
+private:
+    using handle_t = detail::coro::coroutine_handle<promise_type>;
+
+    handle_t _handle;
+
+    explicit lazy_task(handle_t handle) : _handle(handle) {}
+
+    friend promise_type;
+
+    struct awaiter {
+        handle_t _handle;
+
+        bool await_ready() const noexcept { return false; }
+
+        detail::coro::coroutine_handle<> await_suspend(
+            detail::coro::coroutine_handle<> awaiting) noexcept {
+            _handle.promise()._continuation = awaiting;
+            return _handle;
+        }
+
+        T await_resume() { return _handle.promise().result(); }
+    };
+
+public:
+    lazy_task() = default;
+
+    lazy_task(lazy_task&& x) noexcept : _handle(std::exchange(x._handle, nullptr)) {}
+
+    lazy_task& operator=(lazy_task&& x) noexcept {
+        if (this != &x) {
+            if (_handle) _handle.destroy();
+            _handle = std::exchange(x._handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~lazy_task() {
+        if (_handle) _handle.destroy();
+    }
+
+    bool valid() const { return static_cast<bool>(_handle); }
+
+    awaiter operator co_await() && noexcept { return awaiter{_handle}; }
+
+    // Starts the task on the calling thread
+    future<T> to_future() && { return to_future_(std::move(*this)); }
+
+    // Starts the task as a task on executor
+    template <typename E>
+    future<T> to_future(E executor) && {
+        return to_future_(std::move(*this), std::move(executor));
+    }
+
+private:
+    static future<T> to_future_(lazy_task x) { co_return co_await std::move(x); }
+
+    template <typename E>
+    static future<T> to_future_(lazy_task x, E executor) {
+        co_await schedule_on(std::move(executor));
+        co_return co_await std::move(x);
+    }
+};
+
+/**************************************************************************************************/
+
+namespace detail {
+
+template <typename T>
+lazy_task<T> lazy_promise<T>::get_return_object() {
+    return lazy_task<T>(coro::coroutine_handle<lazy_promise>::from_promise(*this));
+}
+
+inline lazy_task<void> lazy_promise<void>::get_return_object() {
+    return lazy_task<void>(coro::coroutine_handle<lazy_promise>::from_promise(*this));
+}
+
+} // namespace detail
+
+/**************************************************************************************************/
+
+} // namespace v1
+
+/**************************************************************************************************/
+
+} // namespace stlab
+
+/**************************************************************************************************/
+
+#endif
+
+#endif // STLAB_CONCURRENCY_LAZY_TASK_HPP
+
+/**************************************************************************************************/
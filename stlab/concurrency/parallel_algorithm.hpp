@@ -0,0 +1,306 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#ifndef STLAB_CONCURRENCY_PARALLEL_ALGORITHM_HPP
+#define STLAB_CONCURRENCY_PARALLEL_ALGORITHM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/optional.hpp>
+#include <stlab/concurrency/utility.hpp>
+
+#include <stlab/memory.hpp>
+
+/**************************************************************************************************/
+
+namespace stlab {
+
+/**************************************************************************************************/
+
+inline namespace v1 {
+
+/**************************************************************************************************/
+
+namespace detail {
+
+/**************************************************************************************************/
+
+// The number of elements that are processed between two checks for idle workers
+inline std::size_t parallel_grain(std::size_t n) {
+    const std::size_t threads = (std::max)(1u, std::thread::hardware_concurrency());
+    return (std::max)(std::size_t(1), n / (threads * 64));
+}
+
+/*
+ * The state of a parallel algorithm. The body splits a range by lazy binary splitting: it works
+ * through its range in chunks of _grain elements and only before a chunk, when all tasks that were
+ * submitted before are taken by the executor, it submits the upper half of its remaining range as
+ * a new task. So the ranges are only split as long as there are idle workers to take them and the
+ * number of tasks adapts to the load of the executor.
+ */
+template <typename E, typename I, typename Body>
+struct parallel_shared : std::enable_shared_from_this<parallel_shared<E, I, Body>> {
+    E _executor;
+    std::size_t _grain;
+    Body _body;
+    std::atomic_size_t _running{0};
+    std::atomic_size_t _waiting{0};
+    std::atomic_bool _failed{false};
+    std::exception_ptr _error;
+    packaged_task<> _promise;
+
+    template <typename... A>
+    parallel_shared(E executor, std::size_t grain, A&&... args) :
+        _executor(std::move(executor)), _grain(grain), _body(std::forward<A>(args)...) {}
+
+    // True if all tasks that were submitted are taken by the executor
+    bool idle() const { return _waiting == 0; }
+
+    bool failed() const { return _failed; }
+
+    void spawn(I first, I last) {
+        ++_running;
+        ++_waiting;
+        _executor([_w = make_weak_ptr(this->shared_from_this()), first, last] {
+            auto p = _w.lock();
+            if (!p) return;
+            --p->_waiting;
+            if (!p->failed()) try {
+                    p->_body(*p, first, last);
+                } catch (...) {
+                    p->fail(std::current_exception());
+                }
+            if (--p->_running == 0) p->_promise();
+        });
+    }
+
+    void fail(std::exception_ptr error) {
+        if (_failed.exchange(true)) return;
+        _error = std::move(error);
+    }
+};
+
+template <typename F>
+struct parallel_for_body {
+    F _f;
+
+    explicit parallel_for_body(F f) : _f(std::move(f)) {}
+
+    template <typename S, typename I>
+    void operator()(S& s, I first, I last) {
+        const auto grain = static_cast<decltype(last - first)>(s._grain);
+        while (last - first > grain) {
+            if (s.failed()) return;
+            if (s.idle()) {
+                auto middle = first + (last - first) / 2;
+                s.spawn(middle, last);
+                last = middle;
+                continue;
+            }
+            for (auto next = first + grain; first != next; ++first)
+                _f(first);
+        }
+        for (; first != last; ++first)
+            _f(first);
+    }
+};
+
+template <typename T, typename R, typename U>
+struct parallel_transform_reduce_body {
+    R _reduce;
+    U _transform;
+    std::mutex _mutex;
+    stlab::optional<T> _result;
+
+    parallel_transform_reduce_body(R reduce, U transform) :
+        _reduce(std::move(reduce)), _transform(std::move(transform)) {}
+
+    template <typename S, typename I>
+    void operator()(S& s, I first, I last) {
+        // Each task reduces its elements locally and merges the partial result once at the end
+        stlab::optional<T> partial;
+        auto accumulate = [&](I next) {
+            for (; first != next; ++first) {
+                if (partial)
+                    partial = _reduce(std::move(*partial), _transform(*first));
+                else
+                    partial = _transform(*first);
+            }
+        };
+
+        const auto grain = static_cast<decltype(last - first)>(s._grain);
+        while (last - first > grain) {
+            if (s.failed()) return;
+            if (s.idle()) {
+                auto middle = first + (last - first) / 2;
+                s.spawn(middle, last);
+                last = middle;
+                continue;
+            }
+            accumulate(first + grain);
+        }
+        accumulate(last);
+
+        if (!partial) return;
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (_result)
+            _result = _reduce(std::move(*_result), std::move(*partial));
+        else
+            _result = std::move(partial);
+    }
+};
+
+template <typename C>
+struct parallel_sort_body {
+    C _compare;
+
+    explicit parallel_sort_body(C compare) : _compare(std::move(compare)) {}
+
+    template <typename S, typename I>
+    void operator()(S& s, I first, I last) {
+        const auto grain = static_cast<decltype(last - first)>(s._grain);
+        while (last - first > grain) {
+            if (s.failed()) return;
+
+            /*
+                Three way partition around the median of three, equal elements are not sorted
+                again. The pivot is swapped out of the way of each partition and compared in place,
+                so elements are only ever swapped, never copied.
+            */
+            auto middle = first + (last - first) / 2, back = last - 1;
+            auto pivot = _compare(*first, *middle) ?
+                             (_compare(*middle, *back) ? middle :
+                                                         (_compare(*first, *back) ? back : first)) :
+                             (_compare(*first, *back) ? first :
+                                                        (_compare(*middle, *back) ? back : middle));
+            std::iter_swap(pivot, back);
+            auto lower =
+                std::partition(first, back, [&](const auto& x) { return _compare(x, *back); });
+            std::iter_swap(lower, back);
+            auto upper = std::partition(lower + 1, last,
+                                        [&](const auto& x) { return !_compare(*lower, x); });
+
+            if (s.idle()) {
+                s.spawn(upper, last);
+                last = lower;
+            } else if (lower - first < last - upper) {
+                (*this)(s, first, lower);
+                first = upper;
+            } else {
+                (*this)(s, upper, last);
+                last = lower;
+            }
+        }
+        std::sort(first, last, _compare);
+    }
+};
+
+template <typename Body, typename E, typename I, typename F, typename... A>
+auto parallel_run(E executor, I first, I last, std::size_t grain, F&& result, A&&... args) {
+    using shared_t = parallel_shared<E, I, Body>;
+
+    auto shared = std::make_shared<shared_t>(executor, grain, std::forward<A>(args)...);
+
+    auto p = package<std::result_of_t<F(shared_t&)>()>(
+        std::move(executor), [_hold = shared, _f = std::forward<F>(result)]() mutable {
+            if (_hold->_error) std::rethrow_exception(_hold->_error);
+            return _f(*_hold);
+        });
+    shared->_promise = std::move(p.first);
+    shared->spawn(first, last);
+
+    return std::move(p.second);
+}
+
+/**************************************************************************************************/
+
+} // namespace detail
+
+/**************************************************************************************************/
+
+/*
+ * The parallel algorithms split their range adaptively into tasks on the executor and return a
+ * single future that is ready when the whole range is processed. If a function throws, the parts
+ * that have not started yet are skipped and the future fails with the first error. Dropping the
+ * future cancels the parts that have not started yet. The range must stay valid until the future
+ * is ready.
+ */
+
+/*
+ * parallel_for calls f for each value in [first, last), these can be indices or random access
+ * iterators. f may be called concurrently from different threads.
+ */
+template <typename E, typename I, typename F>
+future<void> parallel_for(E executor, I first, I last, F f) {
+    if (first == last) return make_ready_future(std::move(executor));
+
+    return detail::parallel_run<detail::parallel_for_body<F>>(
+        std::move(executor), first, last,
+        detail::parallel_grain(static_cast<std::size_t>(last - first)), [](auto&) {},
+        std::move(f));
+}
+
+/*
+ * parallel_transform_reduce returns the reduction of init and transform(*i) for each i in
+ * [first, last). As with std::transform_reduce, reduce must be associative and commutative,
+ * because the grouping and order of the reduction is unspecified.
+ */
+template <typename E, typename I, typename T, typename R, typename U>
+future<T> parallel_transform_reduce(E executor, I first, I last, T init, R reduce, U transform) {
+    using body_t = detail::parallel_transform_reduce_body<T, R, U>;
+
+    if (first == last) return make_ready_future(std::move(init), std::move(executor));
+
+    return detail::parallel_run<body_t>(
+        std::move(executor), first, last,
+        detail::parallel_grain(static_cast<std::size_t>(last - first)),
+        [_init = std::move(init)](auto& shared) mutable {
+            auto& body = shared._body;
+            return body._result ? body._reduce(std::move(_init), std::move(*body._result))
+                                : std::move(_init);
+        },
+        std::move(reduce), std::move(transform));
+}
+
+/*
+ * parallel_sort sorts [first, last) with compare by a parallel quick sort. A part is passed to
+ * another task only when a worker is idle, and small parts are sorted with std::sort.
+ */
+template <typename E, typename I, typename C = std::less<>>
+future<void> parallel_sort(E executor, I first, I last, C compare = C()) {
+    if (first == last) return make_ready_future(std::move(executor));
+
+    const auto n = static_cast<std::size_t>(last - first);
+    return detail::parallel_run<detail::parallel_sort_body<C>>(
+        std::move(executor), first, last, (std::max)(detail::parallel_grain(n), std::size_t(512)),
+        [](auto&) {}, std::move(compare));
+}
+
+/**************************************************************************************************/
+
+} // namespace v1
+
+/**************************************************************************************************/
+
+} // namespace stlab
+
+/**************************************************************************************************/
+
+#endif // STLAB_CONCURRENCY_PARALLEL_ALGORITHM_HPP
+
+/**************************************************************************************************/
@@ -0,0 +1,184 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#ifndef STLAB_CONCURRENCY_RETRY_HPP
+#define STLAB_CONCURRENCY_RETRY_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <type_traits>
+
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+#include <stlab/concurrency/system_timer.hpp>
+
+#include <stlab/memory.hpp>
+
+/**************************************************************************************************/
+
+namespace stlab {
+
+/**************************************************************************************************/
+
+inline namespace v1 {
+
+/**************************************************************************************************/
+
+/*
+ * The delay before the n-th retry is _initial_delay * _multiplier^(n-1), limited to _max_delay.
+ * _jitter is the fraction of the delay that is randomly removed to spread concurrent retries.
+ * Only errors for which _retryable returns true are retried, all others fail immediately.
+ */
+struct retry_policy {
+    std::size_t _max_attempts{3};
+    std::chrono::nanoseconds _initial_delay{std::chrono::milliseconds(10)};
+    std::chrono::nanoseconds _max_delay{std::chrono::seconds(1)};
+    double _multiplier{2.0};
+    double _jitter{0.0};
+    std::function<bool(const std::exception_ptr&)> _retryable;
+
+    std::chrono::nanoseconds delay(std::size_t retry) const {
+        auto result = static_cast<double>(_initial_delay.count());
+        for (std::size_t i = 1; i < retry && result < _max_delay.count(); ++i)
+            result *= _multiplier;
+        result = std::min(result, static_cast<double>(_max_delay.count()));
+
+        if (_jitter > 0.0) {
+            thread_local std::minstd_rand generator{std::random_device{}()};
+            std::uniform_real_distribution<double> distribution(0.0, _jitter);
+            result -= result * distribution(generator);
+        }
+        return std::chrono::nanoseconds(static_cast<std::chrono::nanoseconds::rep>(result));
+    }
+
+    bool retryable(const std::exception_ptr& error) const {
+        return !_retryable || _retryable(error);
+    }
+};
+
+/**************************************************************************************************/
+
+namespace detail {
+
+/**************************************************************************************************/
+
+template <typename T, typename E, typename F>
+struct retry_shared : std::enable_shared_from_this<retry_shared<T, E, F>> {
+    using promise_t = typename owning_promise<T>::task_type;
+
+    std::mutex _mutex;
+    E _executor;
+    retry_policy _policy;
+    F _factory;
+    std::size_t _attempts{0};
+    future<void> _pending;
+    promise_t _promise;
+
+    retry_shared(E executor, retry_policy policy, F factory) :
+        _executor(std::move(executor)), _policy(std::move(policy)),
+        _factory(std::move(factory)) {}
+
+    void launch() {
+        std::size_t index;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            index = ++_attempts;
+        }
+
+        future<T> attempt;
+        try {
+            attempt = _factory();
+        } catch (...) {
+            failure(std::current_exception());
+            return;
+        }
+
+        auto pending = std::move(attempt).recover(
+            immediate_executor, [_w = make_weak_ptr(this->shared_from_this())](auto&& x) {
+                auto p = _w.lock();
+                if (!p) return;
+                if (auto ex = x.exception(); ex)
+                    p->failure(std::move(ex));
+                else
+                    owning_promise<T>::fulfill(p->_promise, std::forward<decltype(x)>(x));
+            });
+
+        // Only the latest attempt is held, so the memory does not grow with the number of retries
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (index == _attempts) _pending = std::move(pending);
+    }
+
+    void failure(std::exception_ptr error) {
+        std::size_t attempts;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            attempts = _attempts;
+        }
+        if (attempts >= _policy._max_attempts || !_policy.retryable(error)) {
+            _promise.set_exception(std::move(error));
+            return;
+        }
+
+        stlab::system_timer(_policy.delay(attempts),
+                            [_w = make_weak_ptr(this->shared_from_this())] {
+                                auto p = _w.lock();
+                                if (!p) return;
+                                p->_executor([_w = std::move(_w)] {
+                                    auto p = _w.lock();
+                                    if (p) p->launch();
+                                });
+                            });
+    }
+};
+
+/**************************************************************************************************/
+
+} // namespace detail
+
+/**************************************************************************************************/
+
+/*
+ * retry calls factory and, as long as the resulting future fails with an error that is retryable
+ * according to the policy, calls it again after an exponentially increasing delay until the
+ * maximum number of attempts is reached. The result fails with the error of the last attempt.
+ * Dropping the result cancels the pending attempt and all further retries.
+ */
+template <typename E, typename F>
+auto retry(E executor, retry_policy policy, F factory) {
+    using result_t = typename std::result_of_t<F()>::result_type;
+    using shared_t = detail::retry_shared<result_t, E, F>;
+    assert(policy._max_attempts > 0);
+
+    auto shared = std::make_shared<shared_t>(executor, std::move(policy), std::move(factory));
+
+    auto p = detail::owning_promise<result_t>::make(std::move(executor), shared);
+    shared->_promise = std::move(p.first);
+    shared->launch();
+
+    return std::move(p.second);
+}
+
+/**************************************************************************************************/
+
+} // namespace v1
+
+/**************************************************************************************************/
+
+} // namespace stlab
+
+/**************************************************************************************************/
+
+#endif // STLAB_CONCURRENCY_RETRY_HPP
+
+/**************************************************************************************************/
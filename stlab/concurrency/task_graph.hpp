@@ -0,0 +1,244 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#ifndef STLAB_CONCURRENCY_TASK_GRAPH_HPP
+#define STLAB_CONCURRENCY_TASK_GRAPH_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/task.hpp>
+#include <stlab/concurrency/utility.hpp>
+
+#include <stlab/memory.hpp>
+
+/**************************************************************************************************/
+
+namespace stlab {
+
+/**************************************************************************************************/
+
+inline namespace v1 {
+
+/**************************************************************************************************/
+
+namespace detail {
+
+/**************************************************************************************************/
+
+/*
+ * The state of a running task_graph. All nodes share flat arrays: the successors of node i are
+ * _successors[_offsets[i], _offsets[i + 1]). Ready nodes are kept in a heap ordered by the length
+ * of their longest remaining path. Each ready node submits one task to the executor and this task
+ * runs the most urgent ready node, which is not necessarily the one that submitted it.
+ */
+template <typename E>
+struct task_graph_shared : std::enable_shared_from_this<task_graph_shared<E>> {
+    E _executor;
+    std::vector<task<void()>> _tasks;
+    std::vector<std::size_t> _priority;
+    std::vector<std::size_t> _offsets;
+    std::vector<std::size_t> _successors;
+    std::unique_ptr<std::atomic_size_t[]> _pending;
+    std::atomic_size_t _remaining;
+    std::mutex _mutex;
+    std::vector<std::size_t> _ready;
+    std::exception_ptr _error;
+    packaged_task<> _promise;
+
+    task_graph_shared(E executor, std::vector<task<void()>> tasks) :
+        _executor(std::move(executor)), _tasks(std::move(tasks)),
+        _pending(new std::atomic_size_t[_tasks.size()]), _remaining(_tasks.size()) {}
+
+    bool less(std::size_t x, std::size_t y) const { return _priority[x] < _priority[y]; }
+
+    void schedule(std::size_t node) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _ready.push_back(node);
+            std::push_heap(_ready.begin(), _ready.end(),
+                           [this](std::size_t x, std::size_t y) { return less(x, y); });
+        }
+        _executor([_w = make_weak_ptr(this->shared_from_this())] {
+            auto p = _w.lock();
+            if (p) p->run_next();
+        });
+    }
+
+    void run_next() {
+        std::size_t node;
+        bool failed;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            std::pop_heap(_ready.begin(), _ready.end(),
+                          [this](std::size_t x, std::size_t y) { return less(x, y); });
+            node = _ready.back();
+            _ready.pop_back();
+            failed = static_cast<bool>(_error);
+        }
+
+        // After a failure the remaining nodes are skipped, but still released in order
+        if (!failed) {
+            try {
+                _tasks[node]();
+            } catch (...) {
+                std::unique_lock<std::mutex> lock(_mutex);
+                if (!_error) _error = std::current_exception();
+            }
+        }
+        _tasks[node] = task<void()>();
+
+        for (auto i = _offsets[node]; i != _offsets[node + 1]; ++i) {
+            auto successor = _successors[i];
+            if (--_pending[successor] == 0) schedule(successor);
+        }
+
+        if (--_remaining == 0) _promise();
+    }
+};
+
+/**************************************************************************************************/
+
+} // namespace detail
+
+/**************************************************************************************************/
+
+/*
+ * task_graph describes a set of tasks and the dependencies between them up front. Each node has a
+ * cost, an estimate of its duration in arbitrary units. When the graph runs, a node starts after
+ * all its predecessors have finished, and of all ready nodes the one with the longest remaining
+ * path, measured as the sum of the costs up to the end of the graph, runs first.
+ *
+ * run() returns a future<void> that is fulfilled when all nodes have finished. If a node throws,
+ * the nodes that have not started yet are skipped and the future fails with the first error.
+ * Dropping the future cancels the nodes that have not started yet. A graph with a cycle is not
+ * run, its future fails with std::logic_error.
+ */
+class task_graph {
+    std::vector<task<void()>> _tasks;
+    std::vector<std::size_t> _costs;
+    std::vector<std::pair<std::size_t, std::size_t>> _edges;
+
+public:
+    using node_t = std::size_t;
+
+    task_graph() = default;
+
+    task_graph(const task_graph&) = delete;
+    task_graph& operator=(const task_graph&) = delete;
+    task_graph(task_graph&&) noexcept = default;
+    task_graph& operator=(task_graph&&) noexcept = default;
+
+    // Adds a node with the task f, which must be callable as void(), and returns its id
+    template <typename F>
+    node_t add(F&& f, std::size_t cost = 1) {
+        _tasks.emplace_back(std::forward<F>(f));
+        _costs.push_back(cost);
+        return _tasks.size() - 1;
+    }
+
+    // Adds an edge, so that node after starts only when node before has finished. Throws
+    // std::out_of_range if a node is unknown.
+    void precede(node_t before, node_t after) {
+        if (before >= size() || after >= size())
+            throw std::out_of_range("task_graph: unknown node");
+        _edges.emplace_back(before, after);
+    }
+
+    std::size_t size() const { return _tasks.size(); }
+
+    template <typename E>
+    future<void> run(E executor) && {
+        using shared_t = detail::task_graph_shared<E>;
+
+        const auto n = size();
+        if (n == 0) return make_ready_future(std::move(executor));
+
+        std::vector<std::size_t> offsets(n + 1, 0);
+        for (const auto& e : _edges)
+            ++offsets[e.first + 1];
+        for (std::size_t i = 0; i != n; ++i)
+            offsets[i + 1] += offsets[i];
+
+        std::vector<std::size_t> successors(_edges.size());
+        std::vector<std::size_t> pending(n, 0);
+        {
+            auto next = offsets;
+            for (const auto& e : _edges) {
+                successors[next[e.first]++] = e.second;
+                ++pending[e.second];
+            }
+        }
+
+        // Topological order by Kahn's algorithm, that leaves out all nodes on a cycle
+        std::vector<std::size_t> order;
+        order.reserve(n);
+        {
+            auto count = pending;
+            for (std::size_t i = 0; i != n; ++i)
+                if (count[i] == 0) order.push_back(i);
+            for (std::size_t k = 0; k != order.size(); ++k) {
+                auto node = order[k];
+                for (auto i = offsets[node]; i != offsets[node + 1]; ++i)
+                    if (--count[successors[i]] == 0) order.push_back(successors[i]);
+            }
+        }
+        if (order.size() != n)
+            return make_exceptional_future(
+                std::make_exception_ptr(std::logic_error("task_graph contains a cycle")),
+                std::move(executor));
+
+        std::vector<std::size_t> priority(n);
+        for (auto k = n; k != 0; --k) {
+            auto node = order[k - 1];
+            std::size_t longest = 0;
+            for (auto i = offsets[node]; i != offsets[node + 1]; ++i)
+                longest = (std::max)(longest, priority[successors[i]]);
+            priority[node] = _costs[node] + longest;
+        }
+
+        auto shared = std::make_shared<shared_t>(executor, std::move(_tasks));
+        shared->_priority = std::move(priority);
+        shared->_offsets = std::move(offsets);
+        shared->_successors = std::move(successors);
+        shared->_ready.reserve(n);
+        for (std::size_t i = 0; i != n; ++i)
+            shared->_pending[i] = pending[i];
+
+        auto p = package<void()>(std::move(executor), [_hold = shared] {
+            if (_hold->_error) std::rethrow_exception(_hold->_error);
+        });
+        shared->_promise = std::move(p.first);
+
+        for (std::size_t i = 0; i != n; ++i)
+            if (pending[i] == 0) shared->schedule(i);
+
+        return std::move(p.second);
+    }
+};
+
+/**************************************************************************************************/
+
+} // namespace v1
+
+/**************************************************************************************************/
+
+} // namespace stlab
+
+/**************************************************************************************************/
+
+#endif // STLAB_CONCURRENCY_TASK_GRAPH_HPP
+
+/**************************************************************************************************/
@@ -0,0 +1,170 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#ifndef STLAB_CONCURRENCY_TASK_GROUP_HPP
+#define STLAB_CONCURRENCY_TASK_GROUP_HPP
+
+#include <atomic>
+#include <cassert>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+
+/**************************************************************************************************/
+
+namespace stlab {
+
+/**************************************************************************************************/
+
+inline namespace v1 {
+
+/**************************************************************************************************/
+
+namespace detail {
+
+/**************************************************************************************************/
+
+/*
+ * _running counts the children that have not finished plus one for the group itself, which is
+ * released by join(). So the result is set exactly once, by whoever drops the count to zero.
+ */
+struct task_group_shared {
+    std::atomic_size_t _running{1};
+    std::atomic_bool _canceled{false};
+    std::mutex _mutex;
+    std::vector<std::exception_ptr> _errors;
+    packaged_task<> _promise;
+
+    void fail(std::exception_ptr error) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _errors.push_back(std::move(error));
+    }
+
+    void release() {
+        if (--_running == 0) _promise();
+    }
+};
+
+/*
+ * Holds the count of a spawned child. The count is released when the child has run, or when the
+ * task is destroyed without running, for example because the executor threw or dropped it.
+ */
+class task_group_child {
+    std::shared_ptr<task_group_shared> _p;
+
+public:
+    explicit task_group_child(std::shared_ptr<task_group_shared> p) : _p(std::move(p)) {
+        const auto running = _p->_running++;
+        assert(running != 0 && "task_group: spawn after the group has finished");
+        (void)running;
+    }
+
+    task_group_child(task_group_child&&) noexcept = default;
+    task_group_child& operator=(task_group_child&&) = delete;
+
+    ~task_group_child() { release(); }
+
+    task_group_shared* operator->() const { return _p.get(); }
+
+    void release() {
+        if (!_p) return;
+        auto p = std::move(_p);
+        p->release();
+    }
+};
+
+/**************************************************************************************************/
+
+} // namespace detail
+
+/**************************************************************************************************/
+
+/*
+ * task_group runs a variable number of children and joins them with a single future<void>.
+ * Children are tracked by a counter, not by futures, so spawning a child costs only the task that
+ * is passed to the executor.
+ *
+ * The future of join() is ready when all children have finished. It fails with the first error of a
+ * child; errors() returns all of them. cancel() skips all children that have not started yet, a
+ * running child can poll canceled(). Destructing a group that was not joined cancels it, so no
+ * child starts after the group is gone. After join() only running children may spawn further
+ * children; they keep the group from finishing while they run. A child that the executor drops
+ * without running it counts as finished, and if the executor throws, spawn() rethrows it.
+ */
+class task_group {
+    std::shared_ptr<detail::task_group_shared> _p{std::make_shared<detail::task_group_shared>()};
+    bool _joined{false};
+
+public:
+    task_group() = default;
+
+    task_group(const task_group&) = delete;
+    task_group& operator=(const task_group&) = delete;
+
+    ~task_group() {
+        if (!_joined) cancel();
+    }
+
+    template <typename E, typename F>
+    void spawn(E executor, F&& f) {
+        executor([_child = detail::task_group_child(_p), _f = std::forward<F>(f)]() mutable {
+            if (!_child->_canceled) try {
+                    std::move(_f)();
+                } catch (...) {
+                    _child->fail(std::current_exception());
+                }
+            _child.release();
+        });
+    }
+
+    void cancel() { _p->_canceled = true; }
+
+    bool canceled() const { return _p->_canceled; }
+
+    template <typename E>
+    future<void> join(E executor) {
+        assert(!_joined && "task_group: join called twice");
+        _joined = true;
+
+        auto p = package<void()>(std::move(executor), [_p = _p] {
+            std::unique_lock<std::mutex> lock(_p->_mutex);
+            if (!_p->_errors.empty()) std::rethrow_exception(_p->_errors.front());
+        });
+        _p->_promise = std::move(p.first);
+        _p->release();
+
+        return std::move(p.second);
+    }
+
+    future<void> join() { return join(immediate_executor); }
+
+    // Only complete when the future of join() is ready
+    std::vector<std::exception_ptr> errors() const {
+        std::unique_lock<std::mutex> lock(_p->_mutex);
+        return _p->_errors;
+    }
+};
+
+/**************************************************************************************************/
+
+} // namespace v1
+
+/**************************************************************************************************/
+
+} // namespace stlab
+
+/**************************************************************************************************/
+
+#endif // STLAB_CONCURRENCY_TASK_GROUP_HPP
+
+/**************************************************************************************************/
@@ -0,0 +1,76 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#ifndef BENCHMARK_HEAP_HPP_
+#define BENCHMARK_HEAP_HPP_
+
+/*
+    Replaces the global operator new and delete to count the allocations and the live bytes of a
+    benchmark. Each block carries a header with its size. The replacement functions are defined
+    here, so the header must be included by exactly one translation unit of a benchmark.
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/**************************************************************************************************/
+
+namespace benchmark_heap {
+
+/**************************************************************************************************/
+
+struct counters {
+    std::atomic<std::size_t> _allocations{0};
+    std::atomic<std::size_t> _live{0};
+};
+
+inline counters& heap() {
+    static counters result;
+    return result;
+}
+
+inline std::size_t allocations() { return heap()._allocations; }
+inline std::size_t live_bytes() { return heap()._live; }
+
+// The header keeps the blocks aligned as the global operator new would
+constexpr std::size_t header_size = alignof(std::max_align_t);
+
+/**************************************************************************************************/
+
+} // namespace benchmark_heap
+
+/**************************************************************************************************/
+
+void* operator new(std::size_t size) {
+    auto p = static_cast<char*>(std::malloc(size + benchmark_heap::header_size));
+    if (!p) throw std::bad_alloc();
+    *reinterpret_cast<std::size_t*>(p) = size;
+    ++benchmark_heap::heap()._allocations;
+    benchmark_heap::heap()._live += size;
+    return p + benchmark_heap::header_size;
+}
+
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    auto block = static_cast<char*>(p) - benchmark_heap::header_size;
+    benchmark_heap::heap()._live -= *reinterpret_cast<std::size_t*>(block);
+    std::free(block);
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { operator delete(p); }
+
+/**************************************************************************************************/
+
+#endif // BENCHMARK_HEAP_HPP_
+
+/**************************************************************************************************/
@@ -0,0 +1,224 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <stlab/concurrency/as_completed.hpp>
+#include <stlab/concurrency/default_executor.hpp>
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+#include <stlab/concurrency/utility.hpp>
+#include <stlab/test/model.hpp>
+
+#include <set>
+#include <vector>
+
+#include "channel_test_helper.hpp"
+
+using namespace stlab;
+using namespace channel_test_helper;
+
+namespace {
+
+struct error_counter {
+    std::atomic_int& _values;
+    std::atomic_int& _errors;
+    process_state_scheduled _state{await_forever};
+
+    void await(int) {
+        ++_values;
+    }
+
+    void set_error(std::exception_ptr) {
+        ++_errors;
+    }
+
+    int yield() { return 0; }
+
+    auto state() const { return _state; }
+};
+
+// Records the ids of the values that were moved, a value is moved when it leaves its future
+struct tracked {
+    int _id;
+
+    static std::set<int>& moved() {
+        static std::set<int> result;
+        return result;
+    }
+
+    explicit tracked(int id) : _id(id) {}
+    tracked(const tracked&) = default;
+    tracked(tracked&& x) noexcept : _id(x._id) { moved().insert(_id); }
+    tracked& operator=(const tracked&) = default;
+    tracked& operator=(tracked&& x) noexcept {
+        _id = x._id;
+        moved().insert(_id);
+        return *this;
+    }
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(channel_as_completed, channel_test_fixture_base)
+
+BOOST_AUTO_TEST_CASE(as_completed_emits_all_values) {
+    BOOST_TEST_MESSAGE("as_completed emits all values of a range");
+
+    std::atomic_int sum{0};
+    std::atomic_int count{0};
+    std::vector<future<int>> futures;
+    for (auto i = 1; i <= 10; ++i)
+        futures.push_back(async(default_executor, [i] { return i; }));
+
+    auto receive = as_completed(default_executor, std::make_pair(futures.begin(), futures.end()));
+    auto check = receive | [&](int x) {
+        sum += x;
+        ++count;
+    };
+    receive.set_ready();
+
+    wait_until_done([&] { return count == 10; });
+
+    BOOST_REQUIRE_EQUAL(55, sum);
+}
+
+BOOST_AUTO_TEST_CASE(as_completed_emits_in_order_of_completion) {
+    BOOST_TEST_MESSAGE("as_completed emits the values in the order of completion");
+
+    std::vector<std::pair<packaged_task<int>, future<int>>> packages;
+    for (auto i = 0; i < 4; ++i)
+        packages.push_back(package<int(int)>(immediate_executor, [](int x) { return x; }));
+
+    std::vector<future<int>> futures;
+    for (auto& p : packages)
+        futures.push_back(std::move(p.second));
+
+    std::mutex m;
+    std::vector<int> results;
+    auto receive = as_completed(default_executor, std::make_pair(futures.begin(), futures.end()));
+    auto check = receive | [&](int x) {
+        lock_t lock(m);
+        results.push_back(x);
+    };
+    receive.set_ready();
+
+    for (auto i = 3; i >= 0; --i)
+        packages[i].first(i);
+
+    wait_until_done([&] {
+        lock_t lock(m);
+        return results.size() == 4;
+    });
+
+    BOOST_REQUIRE((std::vector<int>{3, 2, 1, 0}) == results);
+}
+
+BOOST_AUTO_TEST_CASE(as_completed_passes_on_errors) {
+    BOOST_TEST_MESSAGE("as_completed passes failed futures as error downstream");
+
+    std::atomic_int values{0};
+    std::atomic_int errors{0};
+    std::vector<future<int>> futures;
+    futures.push_back(async(default_executor, [] { return 1; }));
+    futures.push_back(
+        async(default_executor, []() -> int { throw std::runtime_error("failure"); }));
+    futures.push_back(async(default_executor, [] { return 3; }));
+
+    auto receive = as_completed(default_executor, std::make_pair(futures.begin(), futures.end()));
+    auto check = receive | error_counter{values, errors};
+    check.set_ready();
+    receive.set_ready();
+
+    wait_until_done([&] { return values + errors == 3; });
+
+    BOOST_REQUIRE_EQUAL(2, values);
+    BOOST_REQUIRE_EQUAL(1, errors);
+}
+
+BOOST_AUTO_TEST_CASE(as_completed_move_only) {
+    BOOST_TEST_MESSAGE("as_completed with move only values");
+
+    std::atomic_int sum{0};
+    std::vector<future<move_only>> futures;
+    for (auto i = 1; i <= 3; ++i)
+        futures.push_back(async(default_executor, [i] { return move_only{i}; }));
+
+    auto receive =
+        as_completed(default_executor, std::make_pair(std::make_move_iterator(futures.begin()),
+                                                      std::make_move_iterator(futures.end())));
+    auto check = receive | [&](move_only x) { sum += x.member(); };
+    receive.set_ready();
+
+    wait_until_done([&] { return sum == 6; });
+
+    BOOST_REQUIRE_EQUAL(6, sum);
+}
+
+BOOST_AUTO_TEST_CASE(as_completed_forwards_only_when_there_is_room) {
+    BOOST_TEST_MESSAGE("as_completed leaves values in their futures while the downstream is full");
+
+    std::vector<future<tracked>> futures;
+    for (auto i = 0; i < 10; ++i)
+        futures.push_back(make_ready_future(tracked{i}, immediate_executor));
+    tracked::moved().clear();
+
+    queued_executor queue;
+    std::vector<int> results;
+    auto receive = as_completed(queue, std::make_pair(futures.begin(), futures.end()));
+    auto check = receive | (buffer_size{1} & [&](tracked x) { results.push_back(x._id); });
+    receive.set_ready();
+
+    // One value is queued in the channel and one waits for room, the others are not touched
+    BOOST_REQUIRE_LE(tracked::moved().size(), 2u);
+
+    queue.run_all();
+
+    BOOST_REQUIRE_EQUAL(10u, results.size());
+}
+
+BOOST_AUTO_TEST_CASE(as_completed_cancels_pending_futures_when_dropped) {
+    BOOST_TEST_MESSAGE("as_completed releases the pending futures when the receiver is dropped");
+
+    std::atomic_int calls{0};
+    auto task = package<int(int)>(immediate_executor, [&](int x) {
+        ++calls;
+        return x;
+    });
+    std::vector<future<int>> futures;
+    futures.push_back(std::move(task.second));
+
+    {
+        auto receive = as_completed(default_executor,
+                                    std::make_pair(std::make_move_iterator(futures.begin()),
+                                                   std::make_move_iterator(futures.end())));
+    }
+
+    task.first(42);
+    BOOST_REQUIRE_EQUAL(0, calls);
+}
+
+BOOST_AUTO_TEST_CASE(as_completed_copies_the_futures) {
+    BOOST_TEST_MESSAGE("as_completed leaves the futures of the range valid");
+
+    std::atomic_int sum{0};
+    std::vector<future<int>> futures;
+    for (auto i = 1; i <= 3; ++i)
+        futures.push_back(make_ready_future(i, immediate_executor));
+
+    auto receive = as_completed(default_executor, std::make_pair(futures.begin(), futures.end()));
+    auto check = receive | [&](int x) { sum += x; };
+    receive.set_ready();
+
+    wait_until_done([&] { return sum == 6; });
+
+    for (auto& f : futures)
+        BOOST_REQUIRE(f.valid() && f.get_try());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
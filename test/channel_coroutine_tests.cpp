@@ -0,0 +1,219 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <stlab/concurrency/channel.hpp>
+#include <stlab/concurrency/channel_coroutine.hpp>
+#include <stlab/concurrency/default_executor.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "channel_test_helper.hpp"
+
+#if STLAB_FUTURE_COROUTINES
+
+using namespace stlab;
+using namespace channel_test_helper;
+
+namespace {
+
+process_coroutine<int(int)> running_sum() {
+    int sum = 0;
+    while (auto x = co_await next_input)
+        co_yield sum += *x;
+}
+
+process_coroutine<int(int)> reverse() {
+    std::vector<int> values;
+    while (auto x = co_await next_input)
+        values.push_back(*x);
+    for (auto i = values.rbegin(); i != values.rend(); ++i)
+        co_yield *i;
+}
+
+process_coroutine<int(int)> recover_errors() {
+    while (true) {
+        stlab::optional<int> x;
+        try {
+            x = co_await next_input;
+            if (!x) co_return;
+        } catch (const std::runtime_error&) {
+            x = -1;
+        }
+        co_yield *x;
+    }
+}
+
+process_coroutine<int(int)> fail_on_negative() {
+    while (auto x = co_await next_input) {
+        if (*x < 0) throw std::runtime_error("negative");
+        co_yield *x;
+    }
+}
+
+struct collect_errors {
+    std::atomic_int& _errors;
+
+    void await(int) {}
+
+    void set_error(std::exception_ptr) { ++_errors; }
+
+    int yield() { return 0; }
+
+    auto state() const { return await_forever; }
+};
+
+} // namespace
+
+using channel_test_fixture_int_1 = channel_test_fixture<int, 1>;
+
+BOOST_FIXTURE_TEST_SUITE(int_channel_process_coroutine, channel_test_fixture_int_1)
+
+BOOST_AUTO_TEST_CASE(int_channel_process_coroutine_running_sum) {
+    BOOST_TEST_MESSAGE("int channel process coroutine with a running sum");
+
+    std::mutex m;
+    std::vector<int> results;
+
+    auto check = _receive[0] | running_sum() | [&](int x) {
+        std::unique_lock<std::mutex> lock(m);
+        results.push_back(x);
+    };
+
+    _receive[0].set_ready();
+    for (auto i = 1; i <= 10; ++i)
+        _send[0](i);
+
+    wait_until_done([&] {
+        std::unique_lock<std::mutex> lock(m);
+        return results.size() == 10;
+    });
+
+    for (auto i = 1; i <= 10; ++i)
+        BOOST_REQUIRE_EQUAL(i * (i + 1) / 2, results[i - 1]);
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_process_coroutine_yields_after_close) {
+    BOOST_TEST_MESSAGE("int channel process coroutine yields all values after close");
+
+    std::mutex m;
+    std::vector<int> results;
+
+    auto check = _receive[0] | reverse() | [&](int x) {
+        std::unique_lock<std::mutex> lock(m);
+        results.push_back(x);
+    };
+
+    _receive[0].set_ready();
+    for (auto i = 0; i < 5; ++i)
+        _send[0](i);
+    _send[0].close();
+
+    wait_until_done([&] {
+        std::unique_lock<std::mutex> lock(m);
+        return results.size() == 5;
+    });
+
+    BOOST_REQUIRE((results == std::vector<int>{4, 3, 2, 1, 0}));
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_process_coroutine_input_ends_only_once_senders_are_gone) {
+    BOOST_TEST_MESSAGE("int channel process coroutine input ends only once all senders are gone");
+
+    sender<int> send;
+    receiver<int> receive;
+    std::tie(send, receive) = channel<int>(immediate_executor);
+
+    std::vector<int> results;
+
+    auto check = receive | reverse() | [&](int x) { results.push_back(x); };
+    receive.set_ready();
+
+    // Each value runs the process and leaves its queue empty
+    for (auto i = 0; i < 3; ++i)
+        send(i);
+
+    BOOST_REQUIRE(results.empty());
+
+    send.close();
+
+    BOOST_REQUIRE((results == std::vector<int>{2, 1, 0}));
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_process_coroutine_with_buffer_size) {
+    BOOST_TEST_MESSAGE("int channel process coroutine with a buffer size");
+
+    std::atomic_int sum{0};
+    std::atomic_int count{0};
+
+    auto check = _receive[0] | (buffer_size{2} & running_sum()) | [&](int x) {
+        sum = x;
+        ++count;
+    };
+
+    _receive[0].set_ready();
+    for (auto i = 1; i <= 100; ++i)
+        _send[0](i);
+
+    wait_until_done([&] { return count == 100; });
+
+    BOOST_REQUIRE_EQUAL(5050, sum);
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_process_coroutine_catches_upstream_error) {
+    BOOST_TEST_MESSAGE("int channel process coroutine catches an upstream error");
+
+    std::mutex m;
+    std::vector<int> results;
+
+    auto check = _receive[0] |
+                 [](int x) {
+                     if (x == 2) throw std::runtime_error("two");
+                     return x;
+                 } |
+                 recover_errors() | [&](int x) {
+                     std::unique_lock<std::mutex> lock(m);
+                     results.push_back(x);
+                 };
+
+    _receive[0].set_ready();
+    for (auto i = 1; i <= 3; ++i)
+        _send[0](i);
+
+    wait_until_done([&] {
+        std::unique_lock<std::mutex> lock(m);
+        return results.size() == 3;
+    });
+
+    BOOST_REQUIRE((results == std::vector<int>{1, -1, 3}));
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_process_coroutine_sends_its_error_downstream) {
+    BOOST_TEST_MESSAGE("int channel process coroutine sends its exception downstream");
+
+    std::atomic_int errors{0};
+
+    auto check = _receive[0] | fail_on_negative() | collect_errors{errors};
+
+    check.set_ready();
+    _receive[0].set_ready();
+    _send[0](1);
+    _send[0](-1);
+
+    wait_until_done([&] { return errors == 1; });
+
+    BOOST_REQUIRE_EQUAL(1, errors);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
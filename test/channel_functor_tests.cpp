@@ -11,8 +11,10 @@
 #include <stlab/concurrency/channel.hpp>
 #include <stlab/concurrency/default_executor.hpp>
 #include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
 #include <stlab/test/model.hpp>
 
+#include <stdexcept>
 #include <vector>
 
 #include "channel_test_helper.hpp"
@@ -221,4 +223,37 @@ BOOST_AUTO_TEST_CASE(move_only_int_channel_int_functor_async) {
     BOOST_REQUIRE_EQUAL(20, result);
 }
 
+BOOST_AUTO_TEST_CASE(int_channel_functor_passes_upstream_error_on) {
+    BOOST_TEST_MESSAGE("int channel functor passes an upstream error on to the next process");
+
+    sender<int> send;
+    receiver<int> receive;
+    std::tie(send, receive) = channel<int>(immediate_executor);
+
+    std::vector<int> results;
+
+    struct collect_errors {
+        std::vector<int>& _results;
+
+        void await(int x) { _results.push_back(x); }
+        void set_error(std::exception_ptr) { _results.push_back(-1); }
+        int yield() { return 0; }
+        auto state() const { return await_forever; }
+    };
+
+    auto hold = receive |
+                [](int x) {
+                    if (x == 2) throw std::runtime_error("two");
+                    return x;
+                } |
+                [](int x) { return x * 10; } | collect_errors{results};
+    hold.set_ready();
+    receive.set_ready();
+
+    for (int i = 0; i < 4; ++i)
+        send(i);
+
+    BOOST_REQUIRE((results == std::vector<int>{0, 10, -1, 30}));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
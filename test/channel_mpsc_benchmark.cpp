@@ -0,0 +1,85 @@
+/*
+    Copyright 2015 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+/*
+    Compares the throughput of a channel with the default queue and of an mpsc_channel<T> for 1,
+    4 and 16 senders that each run on their own thread. It is not run by ctest, start
+    stlab.benchmark.channel_mpsc by hand, optionally with the number of values per run.
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <stlab/concurrency/channel.hpp>
+#include <stlab/concurrency/default_executor.hpp>
+
+/**************************************************************************************************/
+
+using namespace stlab;
+
+/**************************************************************************************************/
+
+template <typename F>
+double run(F make_channel, int senders, int values) {
+    sender<int> send;
+    receiver<int> receive;
+    std::tie(send, receive) = make_channel();
+
+    std::atomic_int count{0};
+    auto hold = receive | [&](int) { ++count; };
+    receive.set_ready();
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int s = 0; s < senders; ++s)
+        threads.emplace_back([send, n = values / senders] {
+            for (int i = 0; i < n; ++i)
+                send(i);
+        });
+    for (auto& t : threads)
+        t.join();
+
+    const auto total = values / senders * senders;
+    while (count != total)
+        std::this_thread::yield();
+
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / total;
+}
+
+/**************************************************************************************************/
+
+int main(int argc, char** argv) {
+    const int values = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    const int repeats = 3;
+
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency()
+              << ", values per run: " << values << ", best of " << repeats << " runs\n";
+    std::cout << "senders  default ns/value  mpsc ns/value\n";
+
+    for (int senders : {1, 4, 16}) {
+        double best_default = 0, best_mpsc = 0;
+        for (int r = 0; r != repeats; ++r) {
+            const auto d = run([] { return channel<int>(default_executor); }, senders, values);
+            const auto m = run(
+                [] { return mpsc_channel<int>(default_executor, buffer_size{0}); }, senders,
+                values);
+            best_default = r == 0 || d < best_default ? d : best_default;
+            best_mpsc = r == 0 || m < best_mpsc ? m : best_mpsc;
+        }
+        std::cout << std::setw(7) << senders << std::setw(18) << std::fixed
+                  << std::setprecision(1) << best_default << std::setw(15) << best_mpsc << "\n";
+    }
+}
@@ -0,0 +1,337 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <stlab/concurrency/channel.hpp>
+#include <stlab/concurrency/default_executor.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "channel_test_helper.hpp"
+
+using namespace stlab;
+using namespace channel_test_helper;
+
+namespace {
+
+// Yields the key and the number of values of that key it has seen before
+struct count_per_key {
+    std::map<int, int> _counts;
+    stlab::optional<std::pair<int, int>> _result;
+
+    void await(int x) { _result = std::make_pair(x % 10, _counts[x % 10]++); }
+
+    std::pair<int, int> yield() {
+        auto result = *_result;
+        _result = nullopt;
+        return result;
+    }
+
+    auto state() const { return _result ? yield_immediate : await_forever; }
+};
+
+struct collect {
+    std::mutex& _mutex;
+    std::vector<std::pair<int, int>>& _results;
+    std::atomic_bool& _ended;
+
+    void await(std::pair<int, int> x) {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _results.push_back(x);
+    }
+
+    void end_of_input() { _ended = true; }
+
+    int yield() { return 0; }
+
+    auto state() const { return await_forever; }
+};
+
+// Stands in for the upstream process of a router and counts its clear to sends
+struct fake_upstream : detail::shared_process_receiver<int> {
+    int _clear_to_sends{0};
+
+    void map(sender<int>) override {}
+    void clear_to_send() override { ++_clear_to_sends; }
+    void add_receiver() override {}
+    void remove_receiver() override {}
+    executor_t executor() const override { return immediate_executor; }
+    void set_buffer_size(size_t) override {}
+    size_t buffer_size() const override { return 1; }
+};
+
+// Stands in for a partition, its free buffer is set by the test
+struct fake_partition : detail::shared_process_sender<int> {
+    std::size_t _free_buffer{0};
+    std::vector<int> _values;
+
+    void send(int x) override { _values.push_back(x); }
+    void send(std::exception_ptr) override {}
+    future<void> async_send(int) override { return make_ready_future(immediate_executor); }
+    future<void> async_send(std::exception_ptr) override {
+        return make_ready_future(immediate_executor);
+    }
+    void add_sender() override {}
+    void remove_sender() override {}
+    std::size_t free_buffer() const override { return _free_buffer; }
+};
+
+} // namespace
+
+using channel_test_fixture_int_1 = channel_test_fixture<int, 1>;
+
+BOOST_FIXTURE_TEST_SUITE(int_channel_parallel_by_key, channel_test_fixture_int_1)
+
+BOOST_AUTO_TEST_CASE(int_channel_parallel_by_key_keeps_order_per_key) {
+    BOOST_TEST_MESSAGE("int channel parallel by key keeps the order of each key");
+
+    std::mutex m;
+    std::vector<int> results;
+
+    auto check = _receive[0] | parallel_by_key(
+                                   4, [](int x) { return x % 10; },
+                                   [] { return [](int x) { return x; }; }) |
+                 [&](int x) {
+                     std::unique_lock<std::mutex> lock(m);
+                     results.push_back(x);
+                 };
+
+    _receive[0].set_ready();
+    for (int i = 0; i < 1000; ++i)
+        _send[0](i);
+
+    wait_until_done([&] {
+        std::unique_lock<std::mutex> lock(m);
+        return results.size() == 1000;
+    });
+
+    std::vector<int> last(10, -1);
+    for (auto x : results) {
+        BOOST_REQUIRE_LT(last[x % 10], x);
+        last[x % 10] = x;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_parallel_by_key_keeps_state_per_key) {
+    BOOST_TEST_MESSAGE("int channel parallel by key sends each key to the same process");
+
+    std::mutex m;
+    std::vector<std::pair<int, int>> results;
+    std::atomic_bool ended{false};
+
+    auto check = _receive[0] |
+                 parallel_by_key(3, [](int x) { return x % 10; }, [] { return count_per_key{}; }) |
+                 collect{m, results, ended};
+
+    check.set_ready();
+    _receive[0].set_ready();
+    for (int i = 0; i < 100; ++i)
+        _send[0](i);
+    _send[0].close();
+
+    wait_until_done([&] { return ended.load(); });
+
+    BOOST_REQUIRE_EQUAL(100u, results.size());
+    std::vector<int> next(10, 0);
+    for (const auto& e : results) {
+        BOOST_REQUIRE_EQUAL(next[e.first], e.second);
+        ++next[e.first];
+    }
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_parallel_by_key_passes_errors_on) {
+    BOOST_TEST_MESSAGE("int channel parallel by key passes an upstream error on");
+
+    std::atomic_int errors{0};
+    std::atomic_int values{0};
+
+    struct count_errors {
+        std::atomic_int& _errors;
+        std::atomic_int& _values;
+
+        void await(int) { ++_values; }
+        void set_error(std::exception_ptr) { ++_errors; }
+        int yield() { return 0; }
+        auto state() const { return await_forever; }
+    };
+
+    auto check = _receive[0] |
+                 [](int x) {
+                     if (x == 5) throw std::runtime_error("five");
+                     return x;
+                 } |
+                 parallel_by_key(
+                     2, [](int x) { return x; }, [] { return [](int x) { return x; }; }) |
+                 count_errors{errors, values};
+
+    check.set_ready();
+    _receive[0].set_ready();
+    for (int i = 0; i < 10; ++i)
+        _send[0](i);
+
+    wait_until_done([&] { return errors + values == 10; });
+
+    BOOST_REQUIRE_EQUAL(1, errors);
+    BOOST_REQUIRE_EQUAL(9, values);
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_parallel_by_key_full_partition_stops_only_its_keys) {
+    BOOST_TEST_MESSAGE("int channel parallel by key passes values by a full partition");
+
+    // Every task gets its own thread, so a blocked partition does not block the others
+    auto executor = [](task<void()> f) { std::thread(std::move(f)).detach(); };
+
+    sender<int> send;
+    receiver<int> receive;
+    std::tie(send, receive) = channel<int>(executor);
+
+    std::atomic_bool open{false};
+    std::atomic_int odd{0};
+    std::atomic_int total{0};
+
+    auto check = receive | parallel_by_key(2, [](int x) { return x % 2; }, [&] {
+                     return [&](int x) {
+                         while (x % 2 == 0 && !open)
+                             std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                         return x;
+                     };
+                 }) |
+                 [&](int x) {
+                     if (x % 2) ++odd;
+                     ++total;
+                 };
+
+    receive.set_ready();
+    // The even partition processes 0 and has 2 in its queue, so it is full
+    for (int x : {0, 2, 1, 3, 5})
+        send(x);
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (odd != 3 && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    const int passed = odd;
+    open = true;
+
+    wait_until_done([&] { return total == 5; });
+
+    BOOST_REQUIRE_EQUAL(3, passed);
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_parallel_by_key_async_send_waits_for_its_partition) {
+    BOOST_TEST_MESSAGE("int channel parallel by key async send waits for room in its partition");
+
+    auto upstream = std::make_shared<fake_upstream>();
+    auto partition = std::make_shared<fake_partition>();
+    detail::key_router<int, identity> router(upstream, identity{});
+    router._partitions.push_back(partition);
+
+    auto f = router.async_send(1);
+    BOOST_REQUIRE(!f.is_ready());
+    BOOST_REQUIRE(partition->_values.empty());
+    BOOST_REQUIRE_EQUAL(0, upstream->_clear_to_sends);
+
+    partition->_free_buffer = 1;
+    router.clear_to_send();
+
+    BOOST_REQUIRE(f.is_ready());
+    BOOST_REQUIRE((partition->_values == std::vector<int>{1}));
+    BOOST_REQUIRE_EQUAL(1, upstream->_clear_to_sends);
+
+    BOOST_REQUIRE(router.async_send(2).is_ready());
+    BOOST_REQUIRE((partition->_values == std::vector<int>{1, 2}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(int_channel_parallel_map, channel_test_fixture_int_1)
+
+BOOST_AUTO_TEST_CASE(int_channel_parallel_map_keeps_input_order) {
+    BOOST_TEST_MESSAGE("int channel parallel map sends the results in the order of the input");
+
+    std::mutex m;
+    std::vector<int> results;
+
+    auto check = _receive[0] | parallel_map(4, [](int x) {
+                     // later values finish earlier
+                     std::this_thread::sleep_for(std::chrono::microseconds(100 * (3 - x % 4)));
+                     return x * 2;
+                 }) |
+                 [&](int x) {
+                     std::unique_lock<std::mutex> lock(m);
+                     results.push_back(x);
+                 };
+
+    _receive[0].set_ready();
+    for (int i = 0; i < 100; ++i)
+        _send[0](i);
+
+    wait_until_done([&] {
+        std::unique_lock<std::mutex> lock(m);
+        return results.size() == 100;
+    });
+
+    for (int i = 0; i < 100; ++i)
+        BOOST_REQUIRE_EQUAL(i * 2, results[i]);
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_parallel_map_sends_errors_in_order) {
+    BOOST_TEST_MESSAGE("int channel parallel map sends an exception in the place of its result");
+
+    std::mutex m;
+    std::vector<int> results;
+    std::atomic_bool ended{false};
+
+    struct collect_with_errors {
+        std::mutex& _mutex;
+        std::vector<int>& _results;
+        std::atomic_bool& _ended;
+
+        void await(int x) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _results.push_back(x);
+        }
+
+        void set_error(std::exception_ptr) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _results.push_back(-1);
+        }
+
+        void end_of_input() { _ended = true; }
+
+        int yield() { return 0; }
+
+        auto state() const { return await_forever; }
+    };
+
+    auto check = _receive[0] | parallel_map(3, [](int x) {
+                     if (x == 4) throw std::runtime_error("four");
+                     return x;
+                 }) |
+                 collect_with_errors{m, results, ended};
+
+    check.set_ready();
+    _receive[0].set_ready();
+    for (int i = 0; i < 8; ++i)
+        _send[0](i);
+    _send[0].close();
+
+    wait_until_done([&] { return ended.load(); });
+
+    BOOST_REQUIRE((results == std::vector<int>{0, 1, 2, 3, -1, 5, 6, 7}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -11,8 +11,13 @@
 #include <stlab/concurrency/channel.hpp>
 #include <stlab/concurrency/default_executor.hpp>
 #include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
 
 #include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <numeric>
+#include <thread>
 #include <vector>
 
 #include "channel_test_helper.hpp"
@@ -297,6 +302,91 @@ BOOST_AUTO_TEST_CASE(int_channel_process_with_two_steps_timed_wo_timeout) {
     BOOST_REQUIRE_EQUAL(85, result);
 }
 
+namespace {
+struct count_close {
+    std::atomic_int& _values;
+    std::atomic_int& _closes;
+    std::atomic_int& _ends;
+
+    void await(int) { ++_values; }
+
+    void close() { ++_closes; }
+
+    void end_of_input() { ++_ends; }
+
+    int yield() { return 0; }
+
+    auto state() const { return await_forever; }
+};
+
+struct yield_all_at_end_of_input {
+    std::vector<int> _values;
+    bool _ended{false};
+
+    void await(int x) { _values.push_back(x); }
+
+    void end_of_input() { _ended = true; }
+
+    int yield() {
+        auto result = _values.front();
+        _values.erase(_values.begin());
+        return result;
+    }
+
+    auto state() const { return _ended && !_values.empty() ? yield_immediate : await_forever; }
+};
+} // namespace
+
+BOOST_AUTO_TEST_CASE(int_channel_process_close_is_called_each_time_the_queue_runs_empty) {
+    BOOST_TEST_MESSAGE("int channel process close is called each time the queue runs empty");
+
+    sender<int> send;
+    receiver<int> receive;
+    std::tie(send, receive) = channel<int>(immediate_executor);
+
+    std::atomic_int values{0};
+    std::atomic_int closes{0};
+    std::atomic_int ends{0};
+
+    auto hold = receive | count_close{values, closes, ends};
+    hold.set_ready();
+    receive.set_ready();
+
+    for (int i = 0; i < 3; ++i)
+        send(i);
+
+    BOOST_REQUIRE_EQUAL(3, values);
+    BOOST_REQUIRE_EQUAL(3, closes);
+    BOOST_REQUIRE_EQUAL(0, ends);
+
+    send.close();
+
+    BOOST_REQUIRE_EQUAL(4, closes);
+    BOOST_REQUIRE_EQUAL(1, ends);
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_process_sends_all_values_yielded_at_end_of_input) {
+    BOOST_TEST_MESSAGE("int channel process sends all values that it yields at the end of input");
+
+    sender<int> send;
+    receiver<int> receive;
+    std::tie(send, receive) = channel<int>(immediate_executor);
+
+    queued_executor queue;
+    std::vector<int> results;
+
+    auto hold = receive | (executor{queue} & yield_all_at_end_of_input{}) |
+                [&](int x) { results.push_back(x); };
+    receive.set_ready();
+
+    for (int i = 0; i < 4; ++i)
+        send(i);
+    send.close();
+    queue.run_all();
+
+    BOOST_REQUIRE((results == std::vector<int>{0, 1, 2, 3}));
+}
+
 namespace {
 struct process_with_set_error {
     explicit process_with_set_error(std::atomic_bool& check) : _check(check) {}
@@ -380,3 +470,318 @@ BOOST_AUTO_TEST_CASE(int_channel_process_close_is_called_on_upstream_error) {
 
     BOOST_REQUIRE_EQUAL(true, check.load());
 }
+
+namespace {
+std::size_t tasks_for_100_values(std::vector<int>& results, quantum q) {
+    sender<int> send;
+    receiver<int> receive;
+    std::tie(send, receive) = channel<int>(immediate_executor);
+
+    queued_executor queue;
+    auto hold = receive |
+                (executor{queue} & buffer_size{0} & q & [&](int x) { results.push_back(x); });
+    receive.set_ready();
+
+    for (int i = 0; i < 100; ++i)
+        send(i);
+
+    return queue.run_all();
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(int_channel_process_with_quantum_of_messages) {
+    BOOST_TEST_MESSAGE("int channel process handles a quantum of messages in one task");
+
+    std::vector<int> results;
+    auto tasks = tasks_for_100_values(results, quantum{10});
+
+    std::vector<int> expected(100);
+    std::iota(expected.begin(), expected.end(), 0);
+    BOOST_REQUIRE(results == expected);
+    BOOST_REQUIRE_LE(tasks, 11u);
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_process_with_quantum_of_time) {
+    BOOST_TEST_MESSAGE("int channel process ends its task when the time quantum is used up");
+
+    std::vector<int> results;
+    auto tasks = tasks_for_100_values(results, quantum{1000, std::chrono::nanoseconds(0)});
+
+    BOOST_REQUIRE_EQUAL(100u, results.size());
+    BOOST_REQUIRE_GE(tasks, 100u);
+}
+
+namespace {
+struct batch_sum {
+    explicit batch_sum(std::vector<std::size_t>& batch_sizes) : _batch_sizes(&batch_sizes) {}
+
+    std::vector<std::size_t>* _batch_sizes;
+    std::vector<int> _sums;
+    process_state_scheduled _state{await_forever};
+
+    void await_batch(std::vector<int>& values) {
+        _batch_sizes->push_back(values.size());
+        _sums.push_back(std::accumulate(values.begin(), values.end(), 0));
+        _state = yield_immediate;
+    }
+
+    void set_error(std::exception_ptr) {
+        _batch_sizes->push_back(0);
+        _sums.push_back(-1);
+        _state = yield_immediate;
+    }
+
+    int yield() {
+        auto result = _sums.front();
+        _sums.erase(_sums.begin());
+        if (_sums.empty()) _state = await_forever;
+        return result;
+    }
+
+    auto state() const { return _state; }
+};
+} // namespace
+
+BOOST_AUTO_TEST_CASE(int_channel_batch_process_receives_all_queued_values) {
+    BOOST_TEST_MESSAGE("int channel batch process receives all queued values in one call");
+
+    sender<int> send;
+    receiver<int> receive;
+    std::tie(send, receive) = channel<int>(immediate_executor);
+
+    queued_executor queue;
+    std::vector<std::size_t> batch_sizes;
+    std::vector<int> results;
+
+    auto hold = receive | (executor{queue} & buffer_size{64} & batch_sum{batch_sizes}) |
+                [&](int x) { results.push_back(x); };
+    receive.set_ready();
+
+    for (int i = 0; i < 100; ++i)
+        send(i);
+    queue.run_all();
+
+    // The values that exceed the buffer size come in a second batch
+    BOOST_REQUIRE((batch_sizes == std::vector<std::size_t>{64, 36}));
+    BOOST_REQUIRE_EQUAL(4950, std::accumulate(results.begin(), results.end(), 0));
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_batch_process_gets_error_after_preceding_values) {
+    BOOST_TEST_MESSAGE("int channel batch process gets an error after the values sent before it");
+
+    sender<int> send;
+    receiver<int> receive;
+    std::tie(send, receive) = channel<int>(immediate_executor);
+
+    queued_executor queue;
+    std::vector<std::size_t> batch_sizes;
+    std::vector<int> results;
+
+    auto hold = receive |
+                [](int x) {
+                    if (x == 5) throw std::runtime_error("five");
+                    return x;
+                } |
+                (executor{queue} & buffer_size{0} & batch_sum{batch_sizes}) |
+                [&](int x) { results.push_back(x); };
+    receive.set_ready();
+
+    for (int i = 0; i < 10; ++i)
+        send(i);
+    queue.run_all();
+
+    BOOST_REQUIRE((batch_sizes == std::vector<std::size_t>{5, 0, 4}));
+    BOOST_REQUIRE((results == std::vector<int>{10, -1, 30}));
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_async_send_waits_for_buffer_space) {
+    BOOST_TEST_MESSAGE("int channel async send is ready once the value fits into the buffer");
+
+    queued_executor queue;
+    sender<int> send;
+    receiver<int> receive;
+    std::tie(send, receive) = channel<int>(queue);
+
+    std::vector<int> results;
+    auto hold = receive | [&](int x) { results.push_back(x); };
+    receive.set_ready();
+
+    auto first = send.async_send(1);
+    auto second = send.async_send(2);
+    auto third = send.async_send(3);
+
+    BOOST_REQUIRE(first.is_ready());
+    BOOST_REQUIRE(!second.is_ready());
+    BOOST_REQUIRE(!third.is_ready());
+
+    queue.run_all();
+
+    BOOST_REQUIRE(second.is_ready());
+    BOOST_REQUIRE(third.is_ready());
+    BOOST_REQUIRE((results == std::vector<int>{1, 2, 3}));
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_async_send_error_waits_for_buffer_space) {
+    BOOST_TEST_MESSAGE("int channel async send of an error waits for room like a value");
+
+    queued_executor queue;
+    sender<int> send;
+    receiver<int> receive;
+    std::tie(send, receive) = channel<int>(queue);
+
+    std::vector<int> results;
+
+    struct collect {
+        std::vector<int>& _results;
+
+        void await(int x) { _results.push_back(x); }
+        void set_error(std::exception_ptr) { _results.push_back(-1); }
+        int yield() { return 0; }
+        auto state() const { return await_forever; }
+    };
+
+    auto hold = receive | collect{results};
+    hold.set_ready();
+    receive.set_ready();
+
+    auto first = send.async_send(1);
+    auto second = send.async_send(std::make_exception_ptr(std::runtime_error("two")));
+    auto third = send.async_send(3);
+
+    BOOST_REQUIRE(first.is_ready());
+    BOOST_REQUIRE(!second.is_ready());
+    BOOST_REQUIRE(!third.is_ready());
+
+    queue.run_all();
+
+    BOOST_REQUIRE(second.is_ready());
+    BOOST_REQUIRE(third.is_ready());
+    BOOST_REQUIRE((results == std::vector<int>{1, -1, 3}));
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_async_send_without_channel) {
+    BOOST_TEST_MESSAGE("int channel async send on a sender without channel fails");
+
+    sender<int> send;
+
+    auto f = send.async_send(42);
+
+    BOOST_REQUIRE_EXCEPTION(f.get_try(), channel_error, ([](const auto& e) {
+                                return e.code() == channel_error_codes::broken_channel;
+                            }));
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_window_by_count_sends_partial_window_at_end_of_input) {
+    BOOST_TEST_MESSAGE("int channel window sends full windows and the partial window at the end");
+
+    sender<int> send;
+    receiver<int> receive;
+    std::tie(send, receive) = channel<int>(immediate_executor);
+
+    queued_executor queue;
+    std::vector<std::vector<int>> results;
+
+    auto hold = receive | (executor{queue} & window<int>(4)) |
+                [&](std::vector<int> x) { results.push_back(std::move(x)); };
+    receive.set_ready();
+
+    for (int i = 0; i < 10; ++i)
+        send(i);
+    send.close();
+    queue.run_all();
+
+    BOOST_REQUIRE((results ==
+                   std::vector<std::vector<int>>{{0, 1, 2, 3}, {4, 5, 6, 7}, {8, 9}}));
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_window_keeps_partial_window_while_the_queue_is_empty) {
+    BOOST_TEST_MESSAGE("int channel window keeps a partial window while the queue is empty");
+
+    sender<int> send;
+    receiver<int> receive;
+    std::tie(send, receive) = channel<int>(immediate_executor);
+
+    std::vector<std::vector<int>> results;
+
+    auto hold = receive | window<int>(4) |
+                [&](std::vector<int> x) { results.push_back(std::move(x)); };
+    receive.set_ready();
+
+    // Each value runs the process and leaves its queue empty
+    for (int i = 0; i < 6; ++i)
+        send(i);
+
+    BOOST_REQUIRE((results == std::vector<std::vector<int>>{{0, 1, 2, 3}}));
+
+    send.close();
+
+    BOOST_REQUIRE((results == std::vector<std::vector<int>>{{0, 1, 2, 3}, {4, 5}}));
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_window_by_duration) {
+    BOOST_TEST_MESSAGE("int channel window sends a partial window once its duration has passed");
+
+    sender<int> send;
+    receiver<int> receive;
+    std::tie(send, receive) = channel<int>(default_executor);
+
+    std::mutex m;
+    std::vector<std::vector<int>> results;
+
+    auto hold = receive | window<int>(100, std::chrono::milliseconds(20)) |
+                [&](std::vector<int> x) {
+                    std::unique_lock<std::mutex> lock(m);
+                    results.push_back(std::move(x));
+                };
+    receive.set_ready();
+
+    for (int i = 0; i < 3; ++i)
+        send(i);
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m);
+            if (!results.empty()) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::unique_lock<std::mutex> lock(m);
+    BOOST_REQUIRE((results == std::vector<std::vector<int>>{{0, 1, 2}}));
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_window_sends_error_after_preceding_values) {
+    BOOST_TEST_MESSAGE("int channel window sends an error after the window before it");
+
+    sender<int> send;
+    receiver<int> receive;
+    std::tie(send, receive) = channel<int>(immediate_executor);
+
+    queued_executor queue;
+    std::vector<int> results;
+
+    struct collect_windows {
+        std::vector<int>& _results;
+
+        void await(std::vector<int> x) { _results.push_back(static_cast<int>(x.size())); }
+        void set_error(std::exception_ptr) { _results.push_back(-1); }
+        int yield() { return 0; }
+        auto state() const { return await_forever; }
+    };
+
+    auto hold = receive |
+                [](int x) {
+                    if (x == 5) throw std::runtime_error("five");
+                    return x;
+                } |
+                (executor{queue} & window<int>(4)) | collect_windows{results};
+    hold.set_ready();
+    receive.set_ready();
+
+    for (int i = 0; i < 10; ++i)
+        send(i);
+    send.close();
+    queue.run_all();
+
+    BOOST_REQUIRE((results == std::vector<int>{4, 1, -1, 4}));
+}
@@ -14,6 +14,8 @@
 #include <stlab/concurrency/task.hpp>
 #include <stlab/scope.hpp>
 
+#include <deque>
+#include <memory>
 #include <queue>
 #include <thread>
 
@@ -57,6 +59,26 @@ public:
     }
 };
 
+// Queues the tasks until run_all() runs them on the calling thread
+struct queued_executor {
+    std::shared_ptr<std::deque<stlab::task<void()>>> _tasks{
+        std::make_shared<std::deque<stlab::task<void()>>>()};
+
+    void operator()(stlab::task<void()> f) const { _tasks->push_back(std::move(f)); }
+
+    // Runs all tasks and returns their number
+    std::size_t run_all() const {
+        std::size_t n = 0;
+        while (!_tasks->empty()) {
+            auto f = std::move(_tasks->front());
+            _tasks->pop_front();
+            f();
+            ++n;
+        }
+        return n;
+    }
+};
+
 struct channel_test_fixture_base {
     template <typename F>
     void wait_until_done(F&& f) const {
@@ -12,7 +12,13 @@
 #define STLAB_DISABLE_FUTURE_COROUTINES
 #endif
 
+#include <atomic>
+#include <limits>
+#include <numeric>
 #include <queue>
+#include <thread>
+#include <vector>
+
 #include <stlab/concurrency/channel.hpp>
 #include <stlab/concurrency/default_executor.hpp>
 #include <stlab/concurrency/future.hpp>
@@ -775,3 +781,195 @@ BOOST_AUTO_TEST_CASE(sender_receiver_swap_tests) {
         BOOST_REQUIRE_EQUAL(2, result1);
     }
 }
+
+BOOST_AUTO_TEST_CASE(channel_broadcast_moves_into_last_receiver) {
+    BOOST_TEST_MESSAGE("channel broadcast copies for all receivers but the last");
+
+    annotate_counters counters;
+    std::atomic_int received{0};
+    {
+        sender<annotate> send;
+        receiver<annotate> receive;
+        tie(send, receive) = channel<annotate>(immediate_executor);
+
+        std::vector<receiver<void>> hold;
+        for (int i = 0; i < 4; ++i)
+            hold.push_back(receive | [&](const annotate&) { ++received; });
+        receive.set_ready();
+
+        send(annotate(counters));
+    }
+
+    BOOST_REQUIRE_EQUAL(4, received);
+    BOOST_REQUIRE_EQUAL(3u, counters._copy_ctor);
+}
+
+BOOST_AUTO_TEST_CASE(channel_share_immutable_broadcast_does_not_copy) {
+    BOOST_TEST_MESSAGE("channel broadcast of a shared immutable value does not copy it");
+
+    annotate_counters counters;
+    std::atomic_int received{0};
+    {
+        sender<annotate> send;
+        receiver<annotate> receive;
+        tie(send, receive) = channel<annotate>(immediate_executor);
+
+        auto shared = receive | share_immutable{};
+        std::vector<receiver<void>> hold;
+        for (int i = 0; i < 4; ++i)
+            hold.push_back(shared | [&](const copy_on_write<annotate>& x) {
+                if (x.read()._counters == &counters) ++received;
+            });
+        shared.set_ready();
+        receive.set_ready();
+
+        send(annotate(counters));
+    }
+
+    BOOST_REQUIRE_EQUAL(4, received);
+    BOOST_REQUIRE_EQUAL(0u, counters._copy_ctor);
+}
+
+BOOST_AUTO_TEST_CASE(int_mpsc_channel_many_senders_keep_their_order) {
+    BOOST_TEST_MESSAGE("int mpsc channel with many senders keeps the order of each sender");
+
+    const int senders = 8;
+    const int values = 1000;
+
+    sender<int> send;
+    receiver<int> receive;
+    tie(send, receive) = mpsc_channel<int>(default_executor, buffer_size{64});
+
+    std::vector<int> last(senders, -1);
+    std::atomic_int count{0};
+    std::atomic_bool ordered{true};
+
+    auto hold = receive | [&](int x) {
+        auto& l = last[x / values];
+        if (x % values != l + 1) ordered = false;
+        l = x % values;
+        ++count;
+    };
+    receive.set_ready();
+
+    std::vector<std::thread> threads;
+    for (int s = 0; s < senders; ++s)
+        threads.emplace_back([send, s] {
+            for (int i = 0; i < values; ++i)
+                send(s * values + i);
+        });
+    for (auto& t : threads)
+        t.join();
+
+    while (count != senders * values)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    BOOST_REQUIRE(ordered);
+}
+
+BOOST_AUTO_TEST_CASE(int_mpsc_channel_honours_buffer_size) {
+    BOOST_TEST_MESSAGE("int mpsc channel reports its buffer and holds async sends beyond it");
+
+    sender<int> send;
+    receiver<int> receive;
+    tie(send, receive) = mpsc_channel<int>(immediate_executor, buffer_size{4});
+
+    std::vector<int> results;
+    auto hold = receive | [&](int x) { results.push_back(x); };
+
+    BOOST_REQUIRE_EQUAL(4u, *send.free_buffer());
+    send(1);
+    send(2);
+    BOOST_REQUIRE_EQUAL(2u, *send.free_buffer());
+    BOOST_REQUIRE(send.async_send(3).is_ready());
+    BOOST_REQUIRE(send.async_send(4).is_ready());
+    auto waiting = send.async_send(5);
+    BOOST_REQUIRE(!waiting.is_ready());
+
+    // Plain sends beyond the buffer are queued in order, as with the default queue
+    send(6);
+
+    receive.set_ready();
+
+    BOOST_REQUIRE(waiting.is_ready());
+    BOOST_REQUIRE((results == std::vector<int>{1, 2, 3, 4, 6, 5}));
+}
+
+BOOST_AUTO_TEST_CASE(int_mpsc_channel_with_unbounded_buffer) {
+    BOOST_TEST_MESSAGE("int mpsc channel with a buffer size of 0 is unbounded");
+
+    sender<int> send;
+    receiver<int> receive;
+    tie(send, receive) = mpsc_channel<int>(default_executor, buffer_size{0});
+
+    std::vector<int> results;
+    std::atomic_int count{0};
+
+    auto hold = receive | [&](int x) {
+        results.push_back(x);
+        ++count;
+    };
+
+    BOOST_REQUIRE_EQUAL(std::numeric_limits<std::size_t>::max(), *send.free_buffer());
+    for (int i = 0; i < 3000; ++i)
+        send(i);
+    receive.set_ready();
+
+    while (count != 3000)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    std::vector<int> expected(3000);
+    std::iota(expected.begin(), expected.end(), 0);
+    BOOST_REQUIRE(results == expected);
+}
+
+BOOST_AUTO_TEST_CASE(int_channel_with_explicit_executor_type) {
+    BOOST_TEST_MESSAGE("int channel with an explicit executor type");
+
+    sender<int> send;
+    receiver<int> receive;
+    tie(send, receive) = channel<int, detail::immediate_executor_type>(immediate_executor);
+
+    int result = 0;
+    auto hold = receive | [&](int x) { result = x; };
+    receive.set_ready();
+    send(42);
+
+    BOOST_REQUIRE_EQUAL(42, result);
+}
+
+BOOST_AUTO_TEST_CASE(mpsc_queue_strategy_resizes_in_order) {
+    BOOST_TEST_MESSAGE("mpsc queue strategy keeps the order while its ring is replaced");
+
+    detail::mpsc_queue_strategy<int> queue;
+    std::vector<int> results;
+    auto pop = [&] {
+        results.push_back(stlab::get<int>(std::get<0>(queue.front())));
+        queue.pop_front();
+    };
+
+    BOOST_REQUIRE(queue.try_append<0>(1));
+    BOOST_REQUIRE(!queue.try_append<0>(2)); // the ring holds one value
+    queue.append<0>(2);
+
+    queue.set_capacity(4);
+    BOOST_REQUIRE(!queue.try_append<0>(3)); // the old ring is not drained yet
+    queue.append<0>(3);
+    BOOST_REQUIRE_EQUAL(3u, queue.queue_size<0>());
+
+    pop(); // drains the old ring, so it is replaced
+    BOOST_REQUIRE(!queue.try_append<0>(4)); // the overflow queue is not drained yet
+    queue.append<0>(4);
+    pop();
+    pop();
+    pop();
+    BOOST_REQUIRE(queue.empty());
+
+    for (int i = 5; i < 9; ++i)
+        BOOST_REQUIRE(queue.try_append<0>(i));
+    BOOST_REQUIRE(!queue.try_append<0>(9));
+    while (!queue.empty())
+        pop();
+
+    BOOST_REQUIRE((results == std::vector<int>{1, 2, 3, 4, 5, 6, 7, 8}));
+}
@@ -140,6 +140,34 @@ BOOST_AUTO_TEST_CASE(task_system_restarts_after_it_went_pending) {
     BOOST_REQUIRE(!done);
 }
 
+BOOST_AUTO_TEST_CASE(task_scheduled_while_the_worker_goes_to_sleep_is_executed) {
+    BOOST_TEST_MESSAGE("A task scheduled while the worker goes to sleep is executed");
+
+    // Each task is scheduled right after the previous one ran, while its worker goes back to sleep.
+    // The short sleeps of the polling preempt the worker at varying points. If the wakeup is lost,
+    // the task waits until a further task is scheduled; that one is scheduled here after a second.
+    const auto iterations = 20000;
+    atomic_int done{0};
+    auto stalled = 0;
+
+    for (auto i = 0; i < iterations; ++i) {
+        default_executor([&] { ++done; });
+
+        const auto timeout = chrono::steady_clock::now() + chrono::seconds(1);
+        while (done != i + 1 && chrono::steady_clock::now() < timeout)
+            this_thread::sleep_for(chrono::microseconds(1));
+
+        if (done != i + 1) {
+            ++stalled;
+            default_executor([] {});
+            while (done != i + 1)
+                rest();
+        }
+    }
+
+    BOOST_REQUIRE_EQUAL(0, stalled);
+}
+
 BOOST_AUTO_TEST_CASE(all_tasks_will_be_executed_according_to_their_prio) {
     BOOST_TEST_MESSAGE("All tasks will be executed according to their prio");
 
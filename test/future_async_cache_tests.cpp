@@ -0,0 +1,169 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <stlab/concurrency/async_cache.hpp>
+#include <stlab/concurrency/default_executor.hpp>
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+#include <stlab/concurrency/utility.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "future_test_helper.hpp"
+
+using namespace stlab;
+using namespace future_test_helper;
+
+BOOST_FIXTURE_TEST_SUITE(future_async_cache, test_fixture<int>)
+
+BOOST_AUTO_TEST_CASE(future_async_cache_coalesces_concurrent_loads) {
+    BOOST_TEST_MESSAGE("running future async_cache coalescing concurrent loads");
+    async_cache<int, int> cache(16);
+    std::atomic_int loads{0};
+    thread_block_context block_context;
+    auto load = make_blocking_functor(
+        [&](int key) {
+            ++loads;
+            return key * 2;
+        },
+        _task_counter, block_context);
+
+    auto f1 = cache.get(make_executor<0>(), load, 21);
+    auto f2 = cache.get(make_executor<0>(), load, 21);
+
+    {
+        lock_t lock(*block_context._mutex);
+        block_context._go = true;
+        block_context._may_proceed = true;
+    }
+    block_context._thread_block.notify_all();
+
+    wait_until_future_completed(f1, f2);
+
+    BOOST_REQUIRE(f1 == f2);
+    BOOST_REQUIRE_EQUAL(42, *f2.get_try());
+    BOOST_REQUIRE_EQUAL(1, loads.load());
+    BOOST_REQUIRE_EQUAL(std::size_t(1), cache.statistics()._misses);
+    BOOST_REQUIRE_EQUAL(std::size_t(1), cache.statistics()._coalesced);
+
+    sut = cache.get(make_executor<0>(), load, 21);
+    BOOST_REQUIRE_EQUAL(42, *sut.get_try());
+    BOOST_REQUIRE_EQUAL(std::size_t(1), cache.statistics()._hits);
+    BOOST_REQUIRE_EQUAL(1, loads.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_async_cache_evicts_least_recently_used) {
+    BOOST_TEST_MESSAGE("running future async_cache least recently used eviction");
+    async_cache<int, int> cache(2, std::chrono::nanoseconds::max(), 1);
+    std::atomic_int loads{0};
+    auto load = [&](int key) {
+        ++loads;
+        return key;
+    };
+
+    (void)cache.get(immediate_executor, load, 1);
+    (void)cache.get(immediate_executor, load, 2);
+    (void)cache.get(immediate_executor, load, 1); // 2 is now the least recently used
+    (void)cache.get(immediate_executor, load, 3);
+
+    BOOST_REQUIRE_EQUAL(std::size_t(2), cache.size());
+    BOOST_REQUIRE_EQUAL(std::size_t(1), cache.statistics()._evictions);
+
+    (void)cache.get(immediate_executor, load, 1);
+    BOOST_REQUIRE_EQUAL(3, loads.load());
+    (void)cache.get(immediate_executor, load, 2);
+    BOOST_REQUIRE_EQUAL(4, loads.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_async_cache_keeps_loads_in_flight) {
+    BOOST_TEST_MESSAGE("running future async_cache eviction with a load in flight");
+    async_cache<int, int> cache(1, std::chrono::nanoseconds::max(), 1);
+    std::atomic_int loads{0};
+    auto load = [&](int key) {
+        ++loads;
+        return key;
+    };
+    std::vector<task<void()>> pending;
+    auto deferred = [&](auto&& f) { pending.emplace_back(std::forward<decltype(f)>(f)); };
+
+    auto f1 = cache.get(deferred, load, 1);
+    (void)cache.get(immediate_executor, load, 2); // exceeds the capacity while 1 is in flight
+    auto f2 = cache.get(deferred, load, 1);
+
+    BOOST_REQUIRE(f1 == f2);
+    BOOST_REQUIRE_EQUAL(std::size_t(1), cache.statistics()._coalesced);
+    BOOST_REQUIRE_EQUAL(std::size_t(0), cache.statistics()._evictions);
+    BOOST_REQUIRE_EQUAL(std::size_t(2), cache.size());
+
+    for (auto& f : pending)
+        f();
+    BOOST_REQUIRE_EQUAL(1, *f2.get_try());
+    BOOST_REQUIRE_EQUAL(2, loads.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_async_cache_reloads_expired_entries) {
+    BOOST_TEST_MESSAGE("running future async_cache time to live");
+    async_cache<std::string, int> cache(8, std::chrono::milliseconds(5));
+    std::atomic_int loads{0};
+    auto load = [&](const std::string&) { return ++loads; };
+
+    sut = cache.get(immediate_executor, load, "a");
+    BOOST_REQUIRE_EQUAL(1, *sut.get_try());
+
+    sut = cache.get(immediate_executor, load, "a");
+    BOOST_REQUIRE_EQUAL(1, *sut.get_try());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    sut = cache.get(immediate_executor, load, "a");
+    BOOST_REQUIRE_EQUAL(2, *sut.get_try());
+}
+
+BOOST_AUTO_TEST_CASE(future_async_cache_time_to_live_starts_with_the_result) {
+    BOOST_TEST_MESSAGE("running future async_cache time to live with a slow load");
+    async_cache<int, int> cache(8, std::chrono::milliseconds(100));
+    std::atomic_int loads{0};
+    auto load = [&](int key) {
+        ++loads;
+        return key;
+    };
+    std::vector<task<void()>> pending;
+    auto deferred = [&](auto&& f) { pending.emplace_back(std::forward<decltype(f)>(f)); };
+
+    sut = cache.get(deferred, load, 42);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    for (auto& f : pending)
+        f();
+
+    sut = cache.get(immediate_executor, load, 42);
+    BOOST_REQUIRE_EQUAL(42, *sut.get_try());
+    BOOST_REQUIRE_EQUAL(1, loads.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_async_cache_does_not_keep_failures) {
+    BOOST_TEST_MESSAGE("running future async_cache with a failing load");
+    async_cache<int, int> cache(8);
+    std::atomic_int loads{0};
+    auto load = [&](int key) {
+        if (++loads == 1) throw test_exception("failure");
+        return key;
+    };
+
+    sut = cache.get(immediate_executor, load, 42);
+    check_failure<test_exception>(sut, "failure");
+
+    sut = cache.get(immediate_executor, load, 42);
+    BOOST_REQUIRE_EQUAL(42, *sut.get_try());
+    BOOST_REQUIRE_EQUAL(2, loads.load());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -10,6 +10,7 @@
 
 #include <stlab/concurrency/default_executor.hpp>
 #include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
 #include <stlab/concurrency/utility.hpp>
 
 #include <stlab/test/model.hpp>
@@ -117,4 +118,72 @@ BOOST_AUTO_TEST_CASE(future_coroutine_combined_void_int) {
     BOOST_REQUIRE(boolCheck.load());
 }
 
+future<int> add_one(future<int> x, std::thread::id& resumed_on) {
+    auto v = co_await std::move(x);
+    resumed_on = std::this_thread::get_id();
+    co_return v + 1;
+}
+
+BOOST_AUTO_TEST_CASE(future_coroutine_resumes_on_producer_without_executor_hop) {
+    BOOST_TEST_MESSAGE("future coroutine resumed directly by the producer");
+    test_setup setup;
+    std::thread::id resumed_on;
+    std::thread::id produced_on;
+
+    auto p = package<int(int)>(make_executor<0>(), [&](int x) {
+        produced_on = std::this_thread::get_id();
+        return x;
+    });
+    auto result = add_one(std::move(p.second), resumed_on);
+
+    std::thread producer([&] { p.first(41); });
+    producer.join();
+
+    BOOST_REQUIRE_EQUAL(42, blocking_get(result));
+    BOOST_REQUIRE(resumed_on == produced_on);
+    BOOST_REQUIRE_EQUAL(0, custom_scheduler<0>::usage_counter());
+}
+
+BOOST_AUTO_TEST_CASE(future_coroutine_with_ready_future) {
+    BOOST_TEST_MESSAGE("future coroutine awaiting a ready future");
+    std::thread::id resumed_on;
+
+    auto result = add_one(make_ready_future(41, immediate_executor), resumed_on);
+
+    BOOST_REQUIRE_EQUAL(42, *result.get_try());
+    BOOST_REQUIRE(resumed_on == std::this_thread::get_id());
+}
+
+future<int> fail_after_await(future<int> x) {
+    auto v = co_await std::move(x);
+    co_return v;
+}
+
+BOOST_AUTO_TEST_CASE(future_coroutine_awaits_failed_future) {
+    BOOST_TEST_MESSAGE("future coroutine awaiting a failed future");
+
+    auto result = fail_after_await(
+        async(default_executor, []() -> int { throw test_exception("failure"); }));
+
+    BOOST_REQUIRE_EXCEPTION(blocking_get(result), test_exception,
+                            ([_m = std::string("failure")](const auto& e) {
+                                return std::string(_m) == std::string(e.what());
+                            }));
+}
+
+future<int> continue_on(stlab::executor_t executor) {
+    co_await schedule_on(std::move(executor));
+    co_return 42;
+}
+
+BOOST_AUTO_TEST_CASE(future_coroutine_schedule_on) {
+    BOOST_TEST_MESSAGE("future coroutine continuing on an executor");
+    test_setup setup;
+
+    auto result = continue_on(make_executor<1>());
+
+    BOOST_REQUIRE_EQUAL(42, blocking_get(result));
+    BOOST_REQUIRE_EQUAL(1, custom_scheduler<1>::usage_counter());
+}
+
 #endif
@@ -0,0 +1,117 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <stlab/concurrency/default_executor.hpp>
+#include <stlab/concurrency/expected.hpp>
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/utility.hpp>
+#include <stlab/test/model.hpp>
+
+#include "future_test_helper.hpp"
+
+using namespace stlab;
+using namespace future_test_helper;
+
+BOOST_FIXTURE_TEST_SUITE(future_expected_int, test_fixture<int>)
+
+BOOST_AUTO_TEST_CASE(future_then_expected_with_value) {
+    BOOST_TEST_MESSAGE("running future then_expected with a value");
+
+    sut = async(make_executor<0>(), [] { return 42; }).then_expected([](expected<int> x) {
+        BOOST_REQUIRE(x.has_value());
+        return *x + 1;
+    });
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(43, *sut.get_try());
+    BOOST_REQUIRE_LE(1, custom_scheduler<0>::usage_counter());
+}
+
+BOOST_AUTO_TEST_CASE(future_then_expected_with_error) {
+    BOOST_TEST_MESSAGE("running future then_expected with an error");
+
+    sut = async(make_executor<0>(), []() -> int { throw test_exception("failure"); })
+              .then_expected(make_executor<1>(), [](const expected<int>& x) {
+                  BOOST_REQUIRE(!x);
+                  BOOST_REQUIRE(x.error());
+                  return 42;
+              });
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(42, *sut.get_try());
+    BOOST_REQUIRE_LE(1, custom_scheduler<1>::usage_counter());
+}
+
+BOOST_AUTO_TEST_CASE(future_then_expected_value_rethrows_error) {
+    BOOST_TEST_MESSAGE("running future then_expected that accesses the value of an error");
+
+    sut = async(make_executor<0>(), []() -> int { throw test_exception("failure"); })
+              .then_expected([](expected<int> x) { return std::move(x).value(); });
+
+    wait_until_future_fails<test_exception>(sut);
+
+    check_failure<test_exception>(sut, "failure");
+}
+
+BOOST_AUTO_TEST_CASE(future_then_forwards_error_without_calling_continuations) {
+    BOOST_TEST_MESSAGE("running future then chain that forwards an error");
+    std::atomic_int calls{0};
+
+    sut = async(make_executor<0>(), []() -> int { throw test_exception("failure"); })
+              .then([&](int x) {
+                  ++calls;
+                  return x;
+              })
+              .then([&](int x) {
+                  ++calls;
+                  return x;
+              })
+              .then_expected([](expected<int> x) { return x ? *x : -1; });
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(-1, *sut.get_try());
+    BOOST_REQUIRE_EQUAL(0, calls.load());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(future_expected_void, test_fixture<void>)
+
+BOOST_AUTO_TEST_CASE(future_void_then_expected_with_error) {
+    BOOST_TEST_MESSAGE("running future void then_expected with an error");
+    std::atomic_bool failed{false};
+
+    sut = async(make_executor<0>(), [] { throw test_exception("failure"); })
+              .then_expected([&](expected<void> x) { failed = !x.has_value(); });
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE(failed);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(future_expected_move_only, test_fixture<move_only>)
+
+BOOST_AUTO_TEST_CASE(future_move_only_then_expected_with_value) {
+    BOOST_TEST_MESSAGE("running future move only then_expected with a value");
+
+    sut = async(make_executor<0>(), [] { return move_only(42); })
+              .then_expected([](expected<move_only> x) { return std::move(x).value(); });
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(42, (*std::move(sut).get_try()).member());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,171 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <stlab/concurrency/default_executor.hpp>
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/hedge.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+#include <stlab/concurrency/utility.hpp>
+
+#include <chrono>
+#include <thread>
+
+#include "future_test_helper.hpp"
+
+using namespace stlab;
+using namespace future_test_helper;
+
+BOOST_FIXTURE_TEST_SUITE(future_hedge_int, test_fixture<int>)
+
+BOOST_AUTO_TEST_CASE(future_hedge_first_attempt_answers) {
+    BOOST_TEST_MESSAGE("running future hedge with a first attempt that answers immediately");
+    auto statistics = std::make_shared<hedge_statistics>();
+
+    sut = hedge(make_executor<0>(), std::chrono::seconds(10),
+                [] { return make_ready_future(42, immediate_executor); }, 3, statistics);
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(42, *sut.get_try());
+    BOOST_REQUIRE_EQUAL(std::size_t(1), statistics->_attempts.load());
+    BOOST_REQUIRE_EQUAL(std::size_t(0), statistics->_winner.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_hedge_second_attempt_wins) {
+    BOOST_TEST_MESSAGE("running future hedge with a first attempt that does not answer");
+    auto statistics = std::make_shared<hedge_statistics>();
+    auto slow = package<int(int)>(immediate_executor, [](int x) { return x; });
+    std::atomic_int calls{0};
+
+    sut = hedge(make_executor<0>(), std::chrono::milliseconds(10),
+                [&] {
+                    if (calls++ == 0) return slow.second;
+                    return async(make_executor<1>(), [] { return 42; });
+                },
+                3, statistics);
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(42, *sut.get_try());
+    BOOST_REQUIRE_EQUAL(std::size_t(2), statistics->_attempts.load());
+    BOOST_REQUIRE_EQUAL(std::size_t(1), statistics->_winner.load());
+
+    // the loser is not taken into account anymore
+    slow.first(4711);
+    BOOST_REQUIRE_EQUAL(42, *sut.get_try());
+}
+
+BOOST_AUTO_TEST_CASE(future_hedge_failed_attempt_starts_next_immediately) {
+    BOOST_TEST_MESSAGE("running future hedge with a failing first attempt");
+    auto statistics = std::make_shared<hedge_statistics>();
+    std::atomic_int calls{0};
+
+    sut = hedge(make_executor<0>(), std::chrono::seconds(10),
+                [&] {
+                    if (calls++ == 0)
+                        return async(make_executor<1>(),
+                                     []() -> int { throw test_exception("failure"); });
+                    return async(make_executor<1>(), [] { return 42; });
+                },
+                3, statistics);
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(42, *sut.get_try());
+    BOOST_REQUIRE_EQUAL(std::size_t(2), statistics->_attempts.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_hedge_all_attempts_fail) {
+    BOOST_TEST_MESSAGE("running future hedge with all attempts failing");
+    auto statistics = std::make_shared<hedge_statistics>();
+
+    sut = hedge(make_executor<0>(), std::chrono::milliseconds(1),
+                [] {
+                    return async(make_executor<1>(),
+                                 []() -> int { throw test_exception("failure"); });
+                },
+                3, statistics);
+
+    wait_until_future_fails<test_exception>(sut);
+
+    check_failure<test_exception>(sut, "failure");
+    BOOST_REQUIRE_EQUAL(std::size_t(3), statistics->_attempts.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_hedge_throwing_factory_fails_the_attempt) {
+    BOOST_TEST_MESSAGE("running future hedge with a factory that throws on the second call");
+    auto statistics = std::make_shared<hedge_statistics>();
+    std::atomic_int calls{0};
+
+    sut = hedge(make_executor<0>(), std::chrono::seconds(10),
+                [&] {
+                    if (calls++ == 0)
+                        return async(make_executor<1>(),
+                                     []() -> int { throw test_exception("failure"); });
+                    throw test_exception("factory");
+                },
+                2, statistics);
+
+    wait_until_future_fails<test_exception>(sut);
+
+    check_failure<test_exception>(sut, "factory");
+    BOOST_REQUIRE_EQUAL(std::size_t(2), statistics->_attempts.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_hedge_failure_restarts_the_delay) {
+    BOOST_TEST_MESSAGE("running future hedge with an attempt that fails before its delay");
+    auto statistics = std::make_shared<hedge_statistics>();
+    std::vector<std::pair<packaged_task<int>, future<int>>> attempts;
+    for (auto i = 0; i < 3; ++i)
+        attempts.push_back(package<int(int)>(immediate_executor, [](int x) { return x; }));
+    std::atomic_int calls{0};
+
+    sut = hedge(make_executor<0>(), std::chrono::milliseconds(400),
+                [&] { return attempts[calls++].second; }, 3, statistics);
+
+    // The failure starts the second attempt at 200ms, the third one is due at 600ms and not at
+    // 400ms, when the timer of the failed attempt fires.
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    attempts[0].first.set_exception(std::make_exception_ptr(test_exception("failure")));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    BOOST_REQUIRE_EQUAL(std::size_t(2), statistics->_attempts.load());
+
+    attempts[1].first(42);
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(42, *sut.get_try());
+    BOOST_REQUIRE_EQUAL(std::size_t(1), statistics->_winner.load());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(future_hedge_void, test_fixture<void>)
+
+BOOST_AUTO_TEST_CASE(future_hedge_void_second_attempt_wins) {
+    BOOST_TEST_MESSAGE("running future hedge void with a first attempt that does not answer");
+    auto statistics = std::make_shared<hedge_statistics>();
+    auto slow = package<void()>(immediate_executor, [] {});
+    std::atomic_int calls{0};
+
+    sut = hedge(make_executor<0>(), std::chrono::milliseconds(10),
+                [&] {
+                    if (calls++ == 0) return slow.second;
+                    return async(make_executor<1>(), [] {});
+                },
+                3, statistics);
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE(sut.get_try());
+    BOOST_REQUIRE_EQUAL(std::size_t(2), statistics->_attempts.load());
+    BOOST_REQUIRE_EQUAL(std::size_t(1), statistics->_winner.load());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,132 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <stlab/concurrency/default_executor.hpp>
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+#include <stlab/concurrency/utility.hpp>
+#include <stlab/test/model.hpp>
+
+#include "future_test_helper.hpp"
+
+using namespace stlab;
+using namespace future_test_helper;
+
+BOOST_FIXTURE_TEST_SUITE(future_lazy_async, test_fixture<int>)
+
+BOOST_AUTO_TEST_CASE(future_lazy_async_starts_with_first_continuation) {
+    BOOST_TEST_MESSAGE("running future lazy_async started by a continuation");
+    std::atomic_int calls{0};
+
+    auto lazy = lazy_async(make_executor<0>(), [&] { return ++calls; });
+
+    BOOST_REQUIRE_EQUAL(0, custom_scheduler<0>::usage_counter());
+    BOOST_REQUIRE(!lazy.get_try());
+
+    sut = lazy.then([](int x) { return x + 41; });
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(42, *sut.get_try());
+    BOOST_REQUIRE_EQUAL(1, calls.load());
+    BOOST_REQUIRE_EQUAL(2, custom_scheduler<0>::usage_counter());
+}
+
+BOOST_AUTO_TEST_CASE(future_lazy_async_with_multiple_continuations_runs_once) {
+    BOOST_TEST_MESSAGE("running future lazy_async with multiple continuations");
+    std::atomic_int calls{0};
+
+    auto lazy = lazy_async(make_executor<0>(),
+                           [&](int x) {
+                               ++calls;
+                               return x;
+                           },
+                           21);
+    auto a = lazy.then([](int x) { return x; });
+    auto b = lazy.then([](int x) { return x; });
+
+    wait_until_future_completed(a, b);
+
+    BOOST_REQUIRE_EQUAL(42, *a.get_try() + *b.get_try());
+    BOOST_REQUIRE_EQUAL(1, calls.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_lazy_async_dropped_never_runs) {
+    BOOST_TEST_MESSAGE("running future lazy_async that is dropped before it is observed");
+    std::atomic_int calls{0};
+
+    {
+        auto lazy = lazy_async(make_executor<0>(), [&] { return ++calls; });
+    }
+
+    BOOST_REQUIRE_EQUAL(0, custom_scheduler<0>::usage_counter());
+    BOOST_REQUIRE_EQUAL(0, calls.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_lazy_async_with_when_all) {
+    BOOST_TEST_MESSAGE("running future lazy_async with when_all");
+
+    sut = when_all(make_executor<1>(), [](int x, int y) { return x + y; },
+                   lazy_async(make_executor<0>(), [] { return 40; }),
+                   lazy_async(make_executor<0>(), [] { return 2; }));
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(42, *sut.get_try());
+    BOOST_REQUIRE_EQUAL(2, custom_scheduler<0>::usage_counter());
+}
+
+BOOST_AUTO_TEST_CASE(future_lazy_async_with_when_any) {
+    BOOST_TEST_MESSAGE("running future lazy_async with when_any");
+
+    sut = when_any(make_executor<1>(), [](int x, std::size_t) { return x; },
+                   lazy_async(make_executor<0>(), [] { return 42; }));
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(42, *sut.get_try());
+}
+
+BOOST_AUTO_TEST_CASE(future_lazy_async_with_blocking_get) {
+    BOOST_TEST_MESSAGE("running future lazy_async with blocking_get");
+
+    BOOST_REQUIRE_EQUAL(42, blocking_get(lazy_async(default_executor, [] { return 42; })));
+}
+
+BOOST_AUTO_TEST_CASE(future_lazy_async_with_failure) {
+    BOOST_TEST_MESSAGE("running future lazy_async with a failing task");
+
+    sut = lazy_async(make_executor<0>(), []() -> int { throw test_exception("failure"); })
+              .then([](int x) { return x; });
+
+    wait_until_future_fails<test_exception>(sut);
+
+    check_failure<test_exception>(sut, "failure");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(future_lazy_async_move_only, test_fixture<move_only>)
+
+BOOST_AUTO_TEST_CASE(future_lazy_async_move_only_starts_with_continuation) {
+    BOOST_TEST_MESSAGE("running future lazy_async of move only type started by a continuation");
+
+    auto lazy = lazy_async(make_executor<0>(), [] { return move_only(42); });
+
+    BOOST_REQUIRE_EQUAL(0, custom_scheduler<0>::usage_counter());
+
+    sut = std::move(lazy).then([](move_only x) { return x; });
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(42, (*std::move(sut).get_try()).member());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,167 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <stlab/concurrency/default_executor.hpp>
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/lazy_task.hpp>
+#include <stlab/concurrency/utility.hpp>
+
+#include <stlab/test/model.hpp>
+
+#include <atomic>
+#include <thread>
+
+#include "future_test_helper.hpp"
+
+#if STLAB_FUTURE_COROUTINES
+
+using namespace stlab;
+using namespace future_test_helper;
+
+namespace {
+
+lazy_task<int> fibonacci(int n) {
+    if (n < 2) co_return n;
+    co_return co_await fibonacci(n - 1) + co_await fibonacci(n - 2);
+}
+
+lazy_task<int> one() { co_return 1; }
+
+lazy_task<int> sum_of_ones(int n) {
+    int result = 0;
+    for (int i = 0; i != n; ++i)
+        result += co_await one();
+    co_return result;
+}
+
+lazy_task<void> increment(std::atomic_int& x) {
+    ++x;
+    co_return;
+}
+
+lazy_task<move_only> make_move_only(int x) { co_return move_only{x}; }
+
+lazy_task<int> fail() {
+    throw test_exception("failure");
+    co_return 0;
+}
+
+lazy_task<int> catch_failure() {
+    try {
+        co_return co_await fail();
+    } catch (const test_exception&) {
+        co_return 42;
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(future_lazy_task_does_not_start_before_it_is_awaited) {
+    BOOST_TEST_MESSAGE("lazy task does not start before it is awaited");
+    std::atomic_int counter{0};
+
+    auto task = increment(counter);
+    BOOST_REQUIRE_EQUAL(0, counter);
+
+    auto f = std::move(task).to_future();
+    BOOST_REQUIRE(f.get_try());
+    BOOST_REQUIRE_EQUAL(1, counter);
+}
+
+BOOST_AUTO_TEST_CASE(future_lazy_task_dropped_never_runs) {
+    BOOST_TEST_MESSAGE("lazy task that is dropped never runs");
+    std::atomic_int counter{0};
+
+    { auto task = increment(counter); }
+
+    BOOST_REQUIRE_EQUAL(0, counter);
+}
+
+BOOST_AUTO_TEST_CASE(future_lazy_task_call_tree) {
+    BOOST_TEST_MESSAGE("lazy task call tree");
+
+    BOOST_REQUIRE_EQUAL(6765, blocking_get(fibonacci(20).to_future()));
+}
+
+BOOST_AUTO_TEST_CASE(future_lazy_task_synchronous_loop) {
+    BOOST_TEST_MESSAGE("lazy task awaiting synchronous tasks in a loop");
+
+    BOOST_REQUIRE_EQUAL(10000, blocking_get(sum_of_ones(10000).to_future()));
+}
+
+BOOST_AUTO_TEST_CASE(future_lazy_task_move_only) {
+    BOOST_TEST_MESSAGE("lazy task with move only result");
+
+    auto result = blocking_get(make_move_only(42).to_future());
+
+    BOOST_REQUIRE_EQUAL(42, result.member());
+}
+
+BOOST_AUTO_TEST_CASE(future_lazy_task_on_executor) {
+    BOOST_TEST_MESSAGE("lazy task started on an executor");
+
+    auto f = fibonacci(10).to_future(make_executor<0>());
+
+    BOOST_REQUIRE_EQUAL(55, blocking_get(std::move(f)));
+    BOOST_REQUIRE_LE(1, custom_scheduler<0>::usage_counter());
+}
+
+BOOST_AUTO_TEST_CASE(future_lazy_task_failure) {
+    BOOST_TEST_MESSAGE("lazy task with failure");
+
+    auto f = fail().to_future();
+
+    BOOST_REQUIRE_EXCEPTION(blocking_get(std::move(f)), test_exception,
+                            ([](const auto& e) { return std::string(e.what()) == "failure"; }));
+    BOOST_REQUIRE_EQUAL(42, blocking_get(catch_failure().to_future()));
+}
+
+BOOST_AUTO_TEST_CASE(future_lazy_task_frames_are_recycled) {
+    BOOST_TEST_MESSAGE("lazy task frames are recycled");
+    auto& pool = detail::frame_pool::local();
+
+    void* first = pool.allocate(100);
+    const auto cached = pool.cached(100);
+    pool.deallocate(first, 100);
+    BOOST_REQUIRE_EQUAL(cached + 1, pool.cached(100));
+
+    void* second = pool.allocate(100);
+    BOOST_REQUIRE_EQUAL(first, second);
+    pool.deallocate(second, 100);
+
+    void* large = pool.allocate(4096);
+    pool.deallocate(large, 4096);
+    BOOST_REQUIRE_EQUAL(0, pool.cached(4096));
+}
+
+BOOST_AUTO_TEST_CASE(future_lazy_task_frame_freed_after_the_pool_is_destroyed) {
+    BOOST_TEST_MESSAGE("lazy task frame freed at thread exit after the frame pool is destroyed");
+
+    struct holder {
+        bool* _pool_destroyed = nullptr;
+        lazy_task<int> _task;
+
+        ~holder() {
+            if (_pool_destroyed) *_pool_destroyed = detail::frame_pool::destroyed();
+        }
+    };
+
+    bool pool_destroyed = false;
+    std::thread([&] {
+        // The holder is constructed before the pool of the thread, so it is destroyed after it
+        thread_local holder h;
+        h._pool_destroyed = &pool_destroyed;
+        h._task = one();
+    }).join();
+
+    BOOST_REQUIRE(pool_destroyed);
+}
+
+#endif
@@ -0,0 +1,165 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <stlab/concurrency/default_executor.hpp>
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+#include <stlab/concurrency/parallel_algorithm.hpp>
+#include <stlab/concurrency/utility.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "future_test_helper.hpp"
+
+using namespace stlab;
+using namespace future_test_helper;
+
+BOOST_FIXTURE_TEST_SUITE(future_parallel_for, test_fixture<void>)
+
+BOOST_AUTO_TEST_CASE(future_parallel_for_visits_each_index_once) {
+    BOOST_TEST_MESSAGE("running future parallel_for over an index range");
+    const std::size_t n = 100000;
+    std::vector<std::atomic_int> visits(n);
+
+    sut = parallel_for(default_executor, std::size_t(0), n, [&](std::size_t i) { ++visits[i]; });
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE(std::all_of(visits.begin(), visits.end(), [](const auto& x) { return x == 1; }));
+}
+
+BOOST_AUTO_TEST_CASE(future_parallel_for_over_iterators) {
+    BOOST_TEST_MESSAGE("running future parallel_for over an iterator range");
+    std::vector<int> values(1000, 1);
+
+    sut = parallel_for(make_executor<0>(), values.begin(), values.end(),
+                       [](std::vector<int>::iterator i) { *i *= 2; });
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(2000, std::accumulate(values.begin(), values.end(), 0));
+    BOOST_REQUIRE_LE(1, custom_scheduler<0>::usage_counter());
+}
+
+BOOST_AUTO_TEST_CASE(future_parallel_for_with_empty_range) {
+    BOOST_TEST_MESSAGE("running future parallel_for over an empty range");
+
+    sut = parallel_for(immediate_executor, 0, 0, [](int) { BOOST_FAIL("must not be called"); });
+
+    BOOST_REQUIRE(sut.get_try());
+}
+
+BOOST_AUTO_TEST_CASE(future_parallel_for_with_failure) {
+    BOOST_TEST_MESSAGE("running future parallel_for with a failing function");
+
+    sut = parallel_for(default_executor, 0, 10000, [](int i) {
+        if (i == 5000) throw test_exception("failure");
+    });
+
+    wait_until_future_fails<test_exception>(sut);
+
+    check_failure<test_exception>(sut, "failure");
+}
+
+BOOST_AUTO_TEST_CASE(future_parallel_for_composes_with_continuations) {
+    BOOST_TEST_MESSAGE("running future parallel_for with a continuation");
+    std::vector<int> values(1000, 0);
+
+    auto result = parallel_for(default_executor, 0, 1000, [&](int i) { values[i] = i; })
+                      .then([&] { return std::accumulate(values.begin(), values.end(), 0); });
+
+    BOOST_REQUIRE_EQUAL(499500, blocking_get(std::move(result)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(future_parallel_transform_reduce, test_fixture<long long>)
+
+BOOST_AUTO_TEST_CASE(future_parallel_transform_reduce_sum_of_squares) {
+    BOOST_TEST_MESSAGE("running future parallel_transform_reduce");
+    std::vector<long long> values(100000);
+    std::iota(values.begin(), values.end(), 0);
+
+    sut = parallel_transform_reduce(default_executor, values.begin(), values.end(), 1LL,
+                                    std::plus<>(), [](long long x) { return x * x; });
+
+    wait_until_future_completed(sut);
+
+    long long expected = 1;
+    for (auto x : values)
+        expected += x * x;
+
+    BOOST_REQUIRE_EQUAL(expected, *sut.get_try());
+}
+
+BOOST_AUTO_TEST_CASE(future_parallel_transform_reduce_with_empty_range) {
+    BOOST_TEST_MESSAGE("running future parallel_transform_reduce over an empty range");
+    std::vector<long long> values;
+
+    sut = parallel_transform_reduce(immediate_executor, values.begin(), values.end(), 42LL,
+                                    std::plus<>(), [](long long x) { return x; });
+
+    BOOST_REQUIRE_EQUAL(42, *sut.get_try());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(future_parallel_sort, test_fixture<void>)
+
+BOOST_AUTO_TEST_CASE(future_parallel_sort_random_values) {
+    BOOST_TEST_MESSAGE("running future parallel_sort");
+    std::vector<int> values(200000);
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(0, 1000);
+    std::generate(values.begin(), values.end(), [&] { return distribution(generator); });
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+
+    sut = parallel_sort(default_executor, values.begin(), values.end());
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE(values == expected);
+}
+
+BOOST_AUTO_TEST_CASE(future_parallel_sort_with_compare) {
+    BOOST_TEST_MESSAGE("running future parallel_sort with a compare function");
+    std::vector<int> values(10000);
+    std::iota(values.begin(), values.end(), 0);
+
+    sut = parallel_sort(make_executor<0>(), values.begin(), values.end(), std::greater<>());
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE(std::is_sorted(values.begin(), values.end(), std::greater<>()));
+}
+
+BOOST_AUTO_TEST_CASE(future_parallel_sort_move_only_values) {
+    BOOST_TEST_MESSAGE("running future parallel_sort over move only values");
+    std::vector<std::unique_ptr<int>> values;
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(0, 100);
+    for (auto i = 0; i < 20000; ++i)
+        values.push_back(std::make_unique<int>(distribution(generator)));
+    auto compare = [](const auto& x, const auto& y) { return *x < *y; };
+
+    sut = parallel_sort(default_executor, values.begin(), values.end(), compare);
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE(std::all_of(values.begin(), values.end(), [](const auto& x) { return !!x; }));
+    BOOST_REQUIRE(std::is_sorted(values.begin(), values.end(), compare));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,84 @@
+/*
+    Copyright 2015 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+/*
+    Measures a chain of continuations that each return a future, so that every step is reduced
+    from a nested future. The chain is attached to a pending future and then started. It reports
+    the heap allocations per step, counted for attaching and running the chain, and the time per
+    step from starting the chain until its result is ready. All continuations run on the immediate
+    executor. It is not run by ctest, start stlab.benchmark.future_reduce by hand, optionally with
+    the number of chains per run.
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+#include <stlab/concurrency/utility.hpp>
+
+#include "benchmark_heap.hpp"
+
+/**************************************************************************************************/
+
+using namespace stlab;
+
+/**************************************************************************************************/
+
+struct result {
+    double _allocations_per_step;
+    double _ns_per_step;
+};
+
+result run(int depth, int chains) {
+    std::size_t allocations = 0;
+    std::chrono::duration<double, std::nano> elapsed{0};
+
+    for (int c = 0; c != chains; ++c) {
+        const auto before = benchmark_heap::allocations();
+
+        auto p = package<int(int)>(immediate_executor, [](int x) { return x; });
+        auto f = std::move(p.second);
+        for (int i = 0; i != depth; ++i)
+            f = std::move(f).then(
+                [](int x) { return make_ready_future(x + 1, immediate_executor); });
+
+        const auto start = std::chrono::steady_clock::now();
+        p.first(0);
+        elapsed += std::chrono::steady_clock::now() - start;
+
+        allocations += benchmark_heap::allocations() - before;
+        if (!f.get_try() || *f.get_try() != depth) std::abort();
+    }
+
+    return {double(allocations) / chains / depth, elapsed.count() / chains / depth};
+}
+
+/**************************************************************************************************/
+
+int main(int argc, char** argv) {
+    const int chains = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const int repeats = 3;
+
+    std::cout << "chains per run: " << chains << ", best of " << repeats << " runs\n";
+    std::cout << "depth  allocations/step  ns/step\n";
+
+    for (int depth : {1, 10, 100}) {
+        result best{0, 0};
+        for (int r = 0; r != repeats; ++r) {
+            const auto x = run(depth, chains);
+            if (r == 0 || x._ns_per_step < best._ns_per_step) best = x;
+        }
+        std::cout << std::setw(5) << depth << std::fixed << std::setprecision(1)
+                  << std::setw(18) << best._allocations_per_step << std::setw(9)
+                  << best._ns_per_step << "\n";
+    }
+}
@@ -0,0 +1,146 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <stlab/concurrency/default_executor.hpp>
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/retry.hpp>
+#include <stlab/concurrency/utility.hpp>
+
+#include "future_test_helper.hpp"
+
+using namespace stlab;
+using namespace future_test_helper;
+
+namespace {
+
+retry_policy fast_policy(std::size_t max_attempts) {
+    retry_policy result;
+    result._max_attempts = max_attempts;
+    result._initial_delay = std::chrono::milliseconds(1);
+    result._max_delay = std::chrono::milliseconds(4);
+    result._jitter = 0.5;
+    return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(future_retry_policy_delay) {
+    BOOST_TEST_MESSAGE("running future retry policy delay");
+    retry_policy policy;
+    policy._initial_delay = std::chrono::milliseconds(10);
+    policy._max_delay = std::chrono::milliseconds(50);
+
+    BOOST_REQUIRE(std::chrono::milliseconds(10) == policy.delay(1));
+    BOOST_REQUIRE(std::chrono::milliseconds(20) == policy.delay(2));
+    BOOST_REQUIRE(std::chrono::milliseconds(40) == policy.delay(3));
+    BOOST_REQUIRE(std::chrono::milliseconds(50) == policy.delay(4));
+    BOOST_REQUIRE(std::chrono::milliseconds(50) == policy.delay(100));
+
+    policy._jitter = 0.5;
+    for (auto i = 0; i < 10; ++i) {
+        BOOST_REQUIRE(policy.delay(2) <= std::chrono::milliseconds(20));
+        BOOST_REQUIRE(policy.delay(2) >= std::chrono::milliseconds(10));
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE(future_retry_int, test_fixture<int>)
+
+BOOST_AUTO_TEST_CASE(future_retry_succeeds_after_failures) {
+    BOOST_TEST_MESSAGE("running future retry that succeeds after two failures");
+    std::atomic_int calls{0};
+
+    sut = retry(make_executor<0>(), fast_policy(3), [&] {
+        return async(make_executor<1>(), [_n = ++calls]() -> int {
+            if (_n < 3) throw test_exception("failure");
+            return 42;
+        });
+    });
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(42, *sut.get_try());
+    BOOST_REQUIRE_EQUAL(3, calls.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_retry_gives_up_after_max_attempts) {
+    BOOST_TEST_MESSAGE("running future retry that exceeds the maximum attempts");
+    std::atomic_int calls{0};
+
+    sut = retry(make_executor<0>(), fast_policy(4), [&] {
+        ++calls;
+        return async(make_executor<1>(), []() -> int { throw test_exception("failure"); });
+    });
+
+    wait_until_future_fails<test_exception>(sut);
+
+    check_failure<test_exception>(sut, "failure");
+    BOOST_REQUIRE_EQUAL(4, calls.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_retry_does_not_retry_unclassified_errors) {
+    BOOST_TEST_MESSAGE("running future retry with a non retryable error");
+    std::atomic_int calls{0};
+    auto policy = fast_policy(5);
+    policy._retryable = [](const std::exception_ptr& error) {
+        try {
+            std::rethrow_exception(error);
+        } catch (const test_exception&) {
+            return false;
+        } catch (...) {
+            return true;
+        }
+    };
+
+    sut = retry(make_executor<0>(), policy, [&] {
+        ++calls;
+        return async(make_executor<1>(), []() -> int { throw test_exception("failure"); });
+    });
+
+    wait_until_future_fails<test_exception>(sut);
+
+    check_failure<test_exception>(sut, "failure");
+    BOOST_REQUIRE_EQUAL(1, calls.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_retry_with_throwing_factory) {
+    BOOST_TEST_MESSAGE("running future retry with a factory that throws");
+    std::atomic_int calls{0};
+
+    sut = retry(make_executor<0>(), fast_policy(3), [&]() -> future<int> {
+        if (++calls < 2) throw test_exception("failure");
+        return async(make_executor<1>(), [] { return 42; });
+    });
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(42, *sut.get_try());
+    BOOST_REQUIRE_EQUAL(2, calls.load());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(future_retry_void, test_fixture<void>)
+
+BOOST_AUTO_TEST_CASE(future_retry_void_succeeds_after_failure) {
+    BOOST_TEST_MESSAGE("running future retry void that succeeds after one failure");
+    std::atomic_int calls{0};
+
+    sut = retry(make_executor<0>(), fast_policy(3), [&] {
+        return async(make_executor<1>(), [_n = ++calls] {
+            if (_n < 2) throw test_exception("failure");
+        });
+    });
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(2, calls.load());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
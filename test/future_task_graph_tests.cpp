@@ -0,0 +1,200 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <stlab/concurrency/default_executor.hpp>
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+#include <stlab/concurrency/task_graph.hpp>
+#include <stlab/concurrency/utility.hpp>
+
+#include <deque>
+#include <stdexcept>
+#include <string>
+
+#include "future_test_helper.hpp"
+
+using namespace stlab;
+using namespace future_test_helper;
+
+namespace {
+
+// Collects the scheduled tasks, so that the test decides when they run
+struct manual_executor {
+    std::shared_ptr<std::deque<task<void()>>> _tasks{std::make_shared<std::deque<task<void()>>>()};
+
+    void operator()(task<void()> f) const { _tasks->push_back(std::move(f)); }
+
+    void run_all() const {
+        while (!_tasks->empty()) {
+            auto f = std::move(_tasks->front());
+            _tasks->pop_front();
+            f();
+        }
+    }
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(future_task_graph, test_fixture<void>)
+
+BOOST_AUTO_TEST_CASE(future_task_graph_respects_dependencies) {
+    BOOST_TEST_MESSAGE("running future task_graph with a diamond");
+    std::mutex m;
+    std::string order;
+    auto record = [&](char c) {
+        return [&, c] {
+            std::unique_lock<std::mutex> lock(m);
+            order += c;
+        };
+    };
+
+    task_graph graph;
+    auto a = graph.add(record('a'));
+    auto b = graph.add(record('b'));
+    auto c = graph.add(record('c'));
+    auto d = graph.add(record('d'));
+    graph.precede(a, b);
+    graph.precede(a, c);
+    graph.precede(b, d);
+    graph.precede(c, d);
+
+    sut = std::move(graph).run(make_executor<0>());
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(std::size_t(4), order.size());
+    BOOST_REQUIRE_EQUAL('a', order.front());
+    BOOST_REQUIRE_EQUAL('d', order.back());
+    BOOST_REQUIRE_EQUAL(4, custom_scheduler<0>::usage_counter());
+}
+
+BOOST_AUTO_TEST_CASE(future_task_graph_runs_critical_path_first) {
+    BOOST_TEST_MESSAGE("running future task_graph that prefers the longest remaining path");
+    std::string order;
+    auto record = [&](char c) { return [&, c] { order += c; }; };
+
+    // root -> s and root -> l1 -> l2 -> l3, s is added first but l1 is on the longer path
+    task_graph graph;
+    auto root = graph.add(record('r'));
+    auto s = graph.add(record('s'));
+    auto l1 = graph.add(record('1'));
+    auto l2 = graph.add(record('2'));
+    auto l3 = graph.add(record('3'));
+    graph.precede(root, s);
+    graph.precede(root, l1);
+    graph.precede(l1, l2);
+    graph.precede(l2, l3);
+
+    manual_executor executor;
+    sut = std::move(graph).run(executor);
+    executor.run_all();
+
+    BOOST_REQUIRE(sut.get_try());
+    BOOST_REQUIRE_EQUAL(std::size_t(5), order.size());
+    BOOST_REQUIRE_EQUAL(std::string("r12"), order.substr(0, 3));
+}
+
+BOOST_AUTO_TEST_CASE(future_task_graph_uses_costs) {
+    BOOST_TEST_MESSAGE("running future task_graph with costs");
+    std::string order;
+    auto record = [&](char c) { return [&, c] { order += c; }; };
+
+    task_graph graph;
+    auto cheap = graph.add(record('c'));
+    graph.add(record('e'), 10);
+    auto last = graph.add(record('l'));
+    graph.precede(cheap, last);
+
+    manual_executor executor;
+    sut = std::move(graph).run(executor);
+    executor.run_all();
+
+    BOOST_REQUIRE(sut.get_try());
+    BOOST_REQUIRE_EQUAL(std::string("ecl"), order);
+}
+
+BOOST_AUTO_TEST_CASE(future_task_graph_with_cycle) {
+    BOOST_TEST_MESSAGE("running future task_graph with a cycle");
+    std::atomic_int calls{0};
+
+    task_graph graph;
+    auto a = graph.add([&] { ++calls; });
+    auto b = graph.add([&] { ++calls; });
+    auto c = graph.add([&] { ++calls; });
+    graph.precede(a, b);
+    graph.precede(b, c);
+    graph.precede(c, b);
+
+    sut = std::move(graph).run(immediate_executor);
+
+    BOOST_REQUIRE_THROW(sut.get_try(), std::logic_error);
+    BOOST_REQUIRE_EQUAL(0, calls.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_task_graph_with_unknown_node) {
+    BOOST_TEST_MESSAGE("running future task_graph with an edge to an unknown node");
+    std::atomic_int calls{0};
+
+    task_graph graph;
+    auto a = graph.add([&] { ++calls; });
+
+    BOOST_REQUIRE_THROW(graph.precede(a, a + 1), std::out_of_range);
+    BOOST_REQUIRE_THROW(graph.precede(a + 1, a), std::out_of_range);
+
+    sut = std::move(graph).run(immediate_executor);
+
+    BOOST_REQUIRE(sut.get_try());
+    BOOST_REQUIRE_EQUAL(1, calls.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_task_graph_with_failing_node) {
+    BOOST_TEST_MESSAGE("running future task_graph with a failing node");
+    std::atomic_int calls{0};
+
+    task_graph graph;
+    auto a = graph.add([] { throw test_exception("failure"); });
+    auto b = graph.add([&] { ++calls; });
+    graph.precede(a, b);
+
+    sut = std::move(graph).run(make_executor<0>());
+
+    wait_until_future_fails<test_exception>(sut);
+
+    check_failure<test_exception>(sut, "failure");
+    BOOST_REQUIRE_EQUAL(0, calls.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_task_graph_empty) {
+    BOOST_TEST_MESSAGE("running future task_graph without nodes");
+
+    sut = task_graph().run(immediate_executor);
+
+    BOOST_REQUIRE(sut.get_try());
+}
+
+BOOST_AUTO_TEST_CASE(future_task_graph_with_many_nodes) {
+    BOOST_TEST_MESSAGE("running future task_graph with many nodes");
+    const std::size_t n = 1000;
+    std::atomic_size_t calls{0};
+
+    // Every node depends on its two predecessors
+    task_graph graph;
+    for (std::size_t i = 0; i != n; ++i) {
+        auto node = graph.add([&] { ++calls; });
+        if (i > 0) graph.precede(node - 1, node);
+        if (i > 1) graph.precede(node - 2, node);
+    }
+
+    blocking_get(std::move(graph).run(default_executor));
+
+    BOOST_REQUIRE_EQUAL(n, calls.load());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,147 @@
+/*
+    Copyright 2020 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <stlab/concurrency/default_executor.hpp>
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+#include <stlab/concurrency/task_group.hpp>
+#include <stlab/concurrency/utility.hpp>
+
+#include "future_test_helper.hpp"
+
+using namespace stlab;
+using namespace future_test_helper;
+
+BOOST_FIXTURE_TEST_SUITE(future_task_group, test_fixture<void>)
+
+BOOST_AUTO_TEST_CASE(future_task_group_joins_all_children) {
+    BOOST_TEST_MESSAGE("running future task_group join");
+    std::atomic_int calls{0};
+    task_group group;
+
+    for (int i = 0; i != 100; ++i)
+        group.spawn(make_executor<0>(), [&] { ++calls; });
+
+    sut = group.join();
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(100, calls.load());
+    BOOST_REQUIRE_EQUAL(100, custom_scheduler<0>::usage_counter());
+}
+
+BOOST_AUTO_TEST_CASE(future_task_group_join_without_children) {
+    BOOST_TEST_MESSAGE("running future task_group join without children");
+    task_group group;
+
+    sut = group.join();
+
+    BOOST_REQUIRE(sut.get_try());
+}
+
+BOOST_AUTO_TEST_CASE(future_task_group_children_spawn_children) {
+    BOOST_TEST_MESSAGE("running future task_group with children that spawn children");
+    std::atomic_int calls{0};
+    task_group group;
+
+    for (int i = 0; i != 10; ++i)
+        group.spawn(default_executor, [&] {
+            ++calls;
+            group.spawn(default_executor, [&] { ++calls; });
+        });
+
+    // The children may still spawn while the group is joined
+    blocking_get(group.join());
+
+    BOOST_REQUIRE_EQUAL(20, calls.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_task_group_collects_errors) {
+    BOOST_TEST_MESSAGE("running future task_group with failing children");
+    std::atomic_int calls{0};
+    task_group group;
+
+    group.spawn(immediate_executor, [] { throw test_exception("failure"); });
+    group.spawn(immediate_executor, [&] { ++calls; });
+    group.spawn(immediate_executor, [] { throw test_exception("failure"); });
+
+    sut = group.join(make_executor<0>());
+
+    check_failure<test_exception>(sut, "failure");
+    BOOST_REQUIRE_EQUAL(1, calls.load());
+    BOOST_REQUIRE_EQUAL(std::size_t(2), group.errors().size());
+}
+
+BOOST_AUTO_TEST_CASE(future_task_group_cancel_skips_pending_children) {
+    BOOST_TEST_MESSAGE("running future task_group cancel");
+    std::atomic_int calls{0};
+    std::vector<task<void()>> pending;
+    auto executor = [&](task<void()> f) { pending.push_back(std::move(f)); };
+    task_group group;
+
+    group.spawn(executor, [&] { ++calls; });
+    group.spawn(executor, [&] { ++calls; });
+    group.cancel();
+    sut = group.join();
+
+    BOOST_REQUIRE(!sut.get_try());
+    for (auto& f : pending)
+        f();
+
+    BOOST_REQUIRE(sut.get_try());
+    BOOST_REQUIRE(group.canceled());
+    BOOST_REQUIRE_EQUAL(0, calls.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_task_group_destruction_cancels) {
+    BOOST_TEST_MESSAGE("running future task_group that is destructed without join");
+    std::atomic_int calls{0};
+    std::vector<task<void()>> pending;
+    auto executor = [&](task<void()> f) { pending.push_back(std::move(f)); };
+
+    {
+        task_group group;
+        group.spawn(executor, [&] { ++calls; });
+    }
+    for (auto& f : pending)
+        f();
+
+    BOOST_REQUIRE_EQUAL(0, calls.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_task_group_dropped_child_is_released) {
+    BOOST_TEST_MESSAGE("running future task_group with an executor that drops the child");
+    std::atomic_int calls{0};
+    task_group group;
+
+    group.spawn([](auto&&) {}, [&] { ++calls; });
+
+    sut = group.join();
+
+    BOOST_REQUIRE(sut.get_try());
+    BOOST_REQUIRE_EQUAL(0, calls.load());
+}
+
+BOOST_AUTO_TEST_CASE(future_task_group_throwing_executor_releases_child) {
+    BOOST_TEST_MESSAGE("running future task_group with an executor that throws");
+    std::atomic_int calls{0};
+    task_group group;
+
+    BOOST_REQUIRE_THROW(
+        group.spawn([](auto&&) { throw test_exception("executor"); }, [&] { ++calls; }),
+        test_exception);
+
+    sut = group.join();
+
+    BOOST_REQUIRE(sut.get_try());
+    BOOST_REQUIRE_EQUAL(0, calls.load());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
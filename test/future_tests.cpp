@@ -371,6 +371,19 @@ BOOST_AUTO_TEST_CASE(future_swap_tests) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(future_shared_state_size) {
+    BOOST_TEST_MESSAGE("running future shared state size");
+
+    // The shared state of a future with a small function shall fit into two cache lines
+    const std::size_t cache_line = 64;
+    auto f = [] { return 42; };
+    auto g = [] {};
+
+    BOOST_REQUIRE_LE(sizeof(detail::shared<int(), decltype(f)>), 2 * cache_line);
+    BOOST_REQUIRE_LE(sizeof(detail::shared<void(), decltype(g)>), 2 * cache_line);
+    BOOST_REQUIRE_LE(sizeof(detail::shared<int(int), int (*)(int)>), 2 * cache_line);
+}
+
 BOOST_FIXTURE_TEST_SUITE(future_then_void, test_fixture<int>)
 
 BOOST_AUTO_TEST_CASE(future_get_try_refref) {
@@ -503,6 +516,9 @@ BOOST_AUTO_TEST_CASE(future_blocking_get_copyable_value_timeout) {
     auto r = stlab::blocking_get(f, std::chrono::milliseconds(500));
     // timeout should have been reached
     BOOST_REQUIRE(!r);
+
+    // With a single worker thread the still running task would delay the tests that follow
+    BOOST_REQUIRE_EQUAL(42, stlab::blocking_get(f));
 }
 
 BOOST_AUTO_TEST_CASE(future_blocking_get_moveonly_value_and_timeout) {
@@ -0,0 +1,100 @@
+/*
+    Copyright 2015 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+/*
+    Compares handling the value or the error of a ready future with recover, which rethrows the
+    error to inspect it, and with then_expected, which does not. The second table passes the future
+    along a chain of ten then continuations first. All continuations run on the immediate
+    executor. It is not run by ctest, start stlab.benchmark.future_then_expected by hand,
+    optionally with the number of futures per run.
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+#include <stlab/concurrency/expected.hpp>
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+#include <stlab/concurrency/utility.hpp>
+
+/**************************************************************************************************/
+
+using namespace stlab;
+
+/**************************************************************************************************/
+
+future<int> source(bool fail) {
+    if (fail)
+        return make_exceptional_future<int>(std::make_exception_ptr(std::runtime_error("failure")),
+                                            immediate_executor);
+    return make_ready_future(1, immediate_executor);
+}
+
+future<int> chain(future<int> f, int length) {
+    for (int i = 0; i != length; ++i)
+        f = std::move(f).then([](int x) { return x + 1; });
+    return f;
+}
+
+int handle_with_recover(future<int> f) {
+    return *std::move(f)
+                .recover([](future<int> x) {
+                    try {
+                        return *x.get_try();
+                    } catch (const std::exception&) {
+                        return -1;
+                    }
+                })
+                .get_try();
+}
+
+int handle_with_then_expected(future<int> f) {
+    return *std::move(f).then_expected([](expected<int> x) { return x ? *x : -1; }).get_try();
+}
+
+// Returns the best of three runs in million futures per second
+template <typename F>
+double run(F handle, bool fail, int length, int futures) {
+    double best = 0;
+    for (int r = 0; r != 3; ++r) {
+        int sum = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i != futures; ++i)
+            sum += handle(chain(source(fail), length));
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (sum != futures * (fail ? -1 : 1 + length)) std::abort();
+        const auto rate = futures / elapsed.count() / 1e6;
+        best = rate > best ? rate : best;
+    }
+    return best;
+}
+
+void report(int length, int futures) {
+    std::cout << "then continuations before the handler: " << length << ", futures per run: "
+              << futures << ", best of 3 runs\n";
+    std::cout << "path   recover M/s  then_expected M/s\n";
+    for (bool fail : {false, true}) {
+        std::cout << (fail ? "error" : "value") << std::fixed << std::setprecision(3)
+                  << std::setw(13) << run(handle_with_recover, fail, length, futures)
+                  << std::setw(19) << run(handle_with_then_expected, fail, length, futures)
+                  << "\n";
+    }
+}
+
+/**************************************************************************************************/
+
+int main(int argc, char** argv) {
+    const int futures = argc > 1 ? std::atoi(argv[1]) : 200000;
+
+    report(0, futures);
+    report(10, futures / 4);
+}
@@ -1141,6 +1141,34 @@ BOOST_AUTO_TEST_CASE(reduction_future_int_to_int) {
         BOOST_REQUIRE_EQUAL(84, *sut.get_try());
     }
 }
+
+BOOST_AUTO_TEST_CASE(reduction_future_int_to_int_without_additional_scheduling) {
+    BOOST_TEST_MESSAGE("running future reduction int to int without additional scheduling");
+
+    sut = async(make_executor<0>(), [] { return 1; })
+              .then(make_executor<0>(),
+                    [](auto x) { return async(make_executor<1>(), [x] { return x + 1; }); })
+              .then(make_executor<0>(),
+                    [](auto x) { return async(make_executor<1>(), [x] { return x + 1; }); });
+
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(3, *sut.get_try());
+    BOOST_REQUIRE_EQUAL(3, custom_scheduler<0>::usage_counter());
+    BOOST_REQUIRE_EQUAL(2, custom_scheduler<1>::usage_counter());
+}
+
+BOOST_AUTO_TEST_CASE(reduction_future_int_to_int_with_failing_inner_future) {
+    BOOST_TEST_MESSAGE("running future reduction int to int with failing inner future");
+
+    sut = async(make_executor<0>(), [] { return 1; }).then(make_executor<0>(), [](auto) {
+        return async(make_executor<1>(), []() -> int { throw test_exception("failure"); });
+    });
+
+    wait_until_future_fails<test_exception>(sut);
+
+    check_failure<test_exception>(sut, "failure");
+}
 BOOST_AUTO_TEST_SUITE_END()
 
 // ----------------------------------------------------------------------------
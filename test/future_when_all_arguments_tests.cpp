@@ -10,6 +10,7 @@
 
 #include <stlab/concurrency/default_executor.hpp>
 #include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
 #include <stlab/concurrency/utility.hpp>
 
 #include <string>
@@ -287,6 +288,27 @@ BOOST_AUTO_TEST_CASE(future_when_all_args_int_with_many_elements_all_failing) {
     BOOST_REQUIRE_LE(1, custom_scheduler<1>::usage_counter());
 }
 
+BOOST_AUTO_TEST_CASE(future_when_all_args_int_failure_releases_pending_arguments) {
+    BOOST_TEST_MESSAGE("running future when_all args int failure releases pending arguments");
+
+    auto sentinel = std::make_shared<int>(0);
+    std::weak_ptr<int> observer = sentinel;
+    auto pending =
+        package<int(int)>(immediate_executor, [_s = std::move(sentinel)](int x) { return x; });
+    auto failing =
+        package<int()>(immediate_executor, []() -> int { throw test_exception("failure"); });
+
+    sut = when_all(
+        immediate_executor, [](int x, int y) { return x + y; }, std::move(failing.second),
+        std::move(pending.second));
+
+    BOOST_REQUIRE(!observer.expired());
+    failing.first();
+
+    check_failure<test_exception>(sut, "failure");
+    BOOST_REQUIRE(observer.expired());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_FIXTURE_TEST_SUITE(future_when_all_args_string_failure, test_fixture<std::string>)
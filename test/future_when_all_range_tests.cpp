@@ -11,6 +11,7 @@
 
 #include <stlab/concurrency/default_executor.hpp>
 #include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
 #include <stlab/concurrency/utility.hpp>
 #include <stlab/test/model.hpp>
 
@@ -241,6 +242,33 @@ BOOST_AUTO_TEST_CASE(future_when_all_int_range_with_diamond_formation_elements)
     BOOST_REQUIRE_LE(1, custom_scheduler<1>::usage_counter());
 }
 
+BOOST_AUTO_TEST_CASE(future_when_all_int_range_with_large_number_of_elements) {
+    BOOST_TEST_MESSAGE("running future when_all int with range of a large number of elements");
+    const int size = 100000;
+    std::vector<stlab::packaged_task<int>> tasks;
+    std::vector<stlab::future<int>> futures;
+    tasks.reserve(size);
+    futures.reserve(size);
+    for (auto i = 0; i < size; ++i) {
+        auto p = package<int(int)>(immediate_executor, [](int x) { return x; });
+        tasks.push_back(std::move(p.first));
+        futures.push_back(std::move(p.second));
+    }
+
+    sut = when_all(make_executor<1>(),
+                   [](std::vector<int> v) { return std::accumulate(v.begin(), v.end(), 0); },
+                   std::make_pair(futures.begin(), futures.end()));
+    futures.clear();
+
+    for (auto& t : tasks)
+        t(1);
+
+    check_valid_future(sut);
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(size, *sut.get_try());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -0,0 +1,221 @@
+/*
+    Copyright 2015 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+#include <numeric>
+#include <boost/test/unit_test.hpp>
+
+#include <stlab/concurrency/default_executor.hpp>
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+#include <stlab/concurrency/utility.hpp>
+#include <stlab/test/model.hpp>
+
+#include "future_test_helper.hpp"
+
+using namespace stlab;
+using namespace future_test_helper;
+
+BOOST_FIXTURE_TEST_SUITE(future_when_n_range_int, test_fixture<int>)
+
+BOOST_AUTO_TEST_CASE(future_when_n_int_zero_of_empty_range) {
+    BOOST_TEST_MESSAGE("running future when_n 0 of an empty range");
+    std::vector<stlab::future<int>> emptyFutures;
+
+    sut = when_n(make_executor<0>(), [](std::vector<int> v) { return static_cast<int>(v.size()); },
+                 0, std::make_pair(emptyFutures.begin(), emptyFutures.end()));
+
+    check_valid_future(sut);
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(0, *sut.get_try());
+    BOOST_REQUIRE_LE(1, custom_scheduler<0>::usage_counter());
+}
+
+BOOST_AUTO_TEST_CASE(future_when_n_int_more_than_range) {
+    BOOST_TEST_MESSAGE("running future when_n with a quorum larger than the range");
+    bool check{false};
+    std::vector<stlab::future<int>> futures;
+    futures.push_back(async(make_executor<0>(), [] { return 1; }));
+
+    sut = when_n(make_executor<1>(),
+                 [& _check = check](std::vector<int>) {
+                     _check = true;
+                     return 0;
+                 },
+                 2, std::make_pair(futures.begin(), futures.end()));
+
+    wait_until_future_fails<stlab::future_error>(sut);
+
+    BOOST_REQUIRE(!check);
+    BOOST_REQUIRE_EQUAL(0, custom_scheduler<1>::usage_counter());
+}
+
+BOOST_AUTO_TEST_CASE(future_when_n_int_two_of_three) {
+    BOOST_TEST_MESSAGE("running future when_n 2 of 3 with int range");
+    size_t p = 0;
+    std::vector<stlab::future<int>> futures;
+    futures.push_back(async(make_executor<0>(), [] { return 1; }));
+    futures.push_back(async(make_executor<0>(), [] { return 2; }));
+    futures.push_back(async(make_executor<0>(), [] { return 3; }));
+
+    sut = when_n(make_executor<1>(),
+                 [& _p = p](std::vector<int> v) {
+                     _p = v.size();
+                     return std::accumulate(v.begin(), v.end(), 0);
+                 },
+                 2, std::make_pair(futures.begin(), futures.end()));
+
+    check_valid_future(sut);
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(size_t(2), p);
+    BOOST_REQUIRE_LE(1 + 2, *sut.get_try());
+    BOOST_REQUIRE_GE(2 + 3, *sut.get_try());
+    BOOST_REQUIRE_LE(1, custom_scheduler<1>::usage_counter());
+}
+
+BOOST_AUTO_TEST_CASE(future_when_n_int_quorum_with_tolerated_failure) {
+    BOOST_TEST_MESSAGE("running future when_n 2 of 3 with one failing");
+    std::vector<stlab::future<int>> futures;
+    futures.push_back(async(make_executor<0>(), []() -> int { throw test_exception("failure"); }));
+    futures.push_back(async(make_executor<0>(), [] { return 2; }));
+    futures.push_back(async(make_executor<0>(), [] { return 3; }));
+
+    sut = when_n(make_executor<1>(),
+                 [](std::vector<int> v) { return std::accumulate(v.begin(), v.end(), 0); }, 2,
+                 std::make_pair(futures.begin(), futures.end()));
+
+    check_valid_future(sut);
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(2 + 3, *sut.get_try());
+}
+
+BOOST_AUTO_TEST_CASE(future_when_n_int_quorum_not_reachable) {
+    BOOST_TEST_MESSAGE("running future when_n 2 of 3 with two failing");
+    bool check{false};
+    std::vector<stlab::future<int>> futures;
+    futures.push_back(async(make_executor<0>(), []() -> int { throw test_exception("failure"); }));
+    futures.push_back(async(make_executor<0>(), [] { return 2; }));
+    futures.push_back(async(make_executor<0>(), []() -> int { throw test_exception("failure"); }));
+
+    sut = when_n(make_executor<1>(),
+                 [& _check = check](std::vector<int>) {
+                     _check = true;
+                     return 0;
+                 },
+                 2, std::make_pair(futures.begin(), futures.end()));
+
+    wait_until_future_fails<test_exception>(sut);
+
+    check_failure<test_exception>(sut, "failure");
+    BOOST_REQUIRE(!check);
+}
+
+BOOST_AUTO_TEST_CASE(future_when_n_int_cancels_remaining_when_quorum_is_reached) {
+    BOOST_TEST_MESSAGE("running future when_n cancelling the remaining futures at the quorum");
+    std::atomic_int calls{0};
+    std::vector<std::pair<packaged_task<int>, future<int>>> tasks;
+    for (auto i = 0; i < 3; ++i)
+        tasks.push_back(package<int(int)>(immediate_executor, [&](int x) {
+            ++calls;
+            return x;
+        }));
+    std::vector<future<int>> futures;
+    for (auto& t : tasks)
+        futures.push_back(std::move(t.second));
+
+    std::vector<task<void()>> pending;
+    auto run_pending = [&] {
+        auto ready = std::move(pending);
+        pending.clear();
+        for (auto& f : ready)
+            f();
+    };
+    sut = when_n([&](auto&& f) { pending.emplace_back(std::forward<decltype(f)>(f)); },
+                 [](std::vector<int> v) { return std::accumulate(v.begin(), v.end(), 0); }, 2,
+                 std::make_pair(futures.begin(), futures.end()));
+    futures.clear();
+
+    tasks[0].first(1);
+    tasks[1].first(2);
+    run_pending();
+
+    tasks[2].first(3);
+    BOOST_REQUIRE_EQUAL(2, calls.load());
+
+    run_pending();
+    BOOST_REQUIRE_EQUAL(3, *sut.get_try());
+}
+
+BOOST_AUTO_TEST_CASE(future_when_n_int_arguments) {
+    BOOST_TEST_MESSAGE("running future when_n 1 of 3 with int arguments");
+    auto f1 = async(make_executor<0>(), [] { return 42; });
+    auto f2 = async(make_executor<0>(), [] { return 42; });
+    auto f3 = async(make_executor<0>(), [] { return 42; });
+
+    sut = when_n(make_executor<1>(), [](std::vector<int> v) { return v.front(); }, 1,
+                 std::move(f1), std::move(f2), std::move(f3));
+
+    check_valid_future(sut);
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(42, *sut.get_try());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(future_when_n_range_void, test_fixture<void>)
+
+BOOST_AUTO_TEST_CASE(future_when_n_void_two_of_three) {
+    BOOST_TEST_MESSAGE("running future when_n 2 of 3 with void range");
+    std::atomic_int counter{0};
+    bool check{false};
+    std::vector<stlab::future<void>> futures;
+    futures.push_back(async(make_executor<0>(), [& _counter = counter] { ++_counter; }));
+    futures.push_back(async(make_executor<0>(), [& _counter = counter] { ++_counter; }));
+    futures.push_back(async(make_executor<0>(), [& _counter = counter] { ++_counter; }));
+
+    sut = when_n(make_executor<1>(), [& _check = check] { _check = true; }, 2,
+                 std::make_pair(futures.begin(), futures.end()));
+
+    check_valid_future(sut);
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE(check);
+    BOOST_REQUIRE_LE(2, counter.load());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_FIXTURE_TEST_SUITE(future_when_n_range_move_only, test_fixture<stlab::move_only>)
+
+BOOST_AUTO_TEST_CASE(future_when_n_move_only_two_of_three) {
+    BOOST_TEST_MESSAGE("running future when_n 2 of 3 with move_only range");
+    std::vector<stlab::future<stlab::move_only>> futures;
+    futures.push_back(async(make_executor<0>(), [] { return stlab::move_only{1}; }));
+    futures.push_back(async(make_executor<0>(), [] { return stlab::move_only{1}; }));
+    futures.push_back(async(make_executor<0>(), [] { return stlab::move_only{1}; }));
+
+    sut = when_n(make_executor<1>(),
+                 [](std::vector<stlab::move_only> v) {
+                     auto r = 0;
+                     for (const auto& i : v) {
+                         r += i.member();
+                     }
+                     return stlab::move_only{r};
+                 },
+                 2, std::make_pair(futures.begin(), futures.end()));
+
+    check_valid_future(sut);
+    wait_until_future_completed(sut);
+
+    BOOST_REQUIRE_EQUAL(2, (*sut.get_try()).member());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,101 @@
+/*
+    Copyright 2015 Adobe
+    Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+/**************************************************************************************************/
+
+/*
+    Measures when_all and when_any over a range of 1k, 100k and 1M pending futures made by
+    package() on the immediate executor. It reports the heap that attaching the combinator adds
+    per input and the inputs per second from attaching it until the last input is fulfilled. It is
+    not run by ctest, start stlab.benchmark.future_when_range by hand, optionally with the number of
+    inputs of a single run.
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include <stlab/concurrency/future.hpp>
+#include <stlab/concurrency/immediate_executor.hpp>
+
+#include "benchmark_heap.hpp"
+
+/**************************************************************************************************/
+
+using namespace stlab;
+
+/**************************************************************************************************/
+
+struct result {
+    double _bytes_per_input;
+    double _inputs_per_second;
+};
+
+template <typename F>
+result run(F attach, int inputs) {
+    std::vector<packaged_task<int>> tasks;
+    std::vector<future<int>> futures;
+    tasks.reserve(inputs);
+    futures.reserve(inputs);
+    for (int i = 0; i != inputs; ++i) {
+        auto p = package<int(int)>(immediate_executor, [](int x) { return x; });
+        tasks.push_back(std::move(p.first));
+        futures.push_back(std::move(p.second));
+    }
+
+    const auto before = benchmark_heap::live_bytes();
+    const auto start = std::chrono::steady_clock::now();
+
+    auto r = attach(futures);
+    const auto attached = benchmark_heap::live_bytes() - before;
+
+    for (auto& t : tasks)
+        t(1);
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (!r.get_try()) std::abort();
+
+    return {double(attached) / inputs, inputs / elapsed.count()};
+}
+
+auto attach_when_all(std::vector<future<int>>& futures) {
+    return when_all(immediate_executor, [](std::vector<int> v) { return v.size(); },
+                    std::make_pair(futures.begin(), futures.end()));
+}
+
+auto attach_when_any(std::vector<future<int>>& futures) {
+    return when_any(immediate_executor, [](int x, std::size_t) { return x; },
+                    std::make_pair(futures.begin(), futures.end()));
+}
+
+/**************************************************************************************************/
+
+int main(int argc, char** argv) {
+    const std::vector<int> sizes =
+        argc > 1 ? std::vector<int>{std::atoi(argv[1])} : std::vector<int>{1000, 100000, 1000000};
+    const int repeats = 3;
+
+    std::cout << "best of " << repeats << " runs\n";
+    std::cout << "    inputs  when_all bytes/input  M inputs/s  when_any bytes/input  M inputs/s\n";
+
+    for (int inputs : sizes) {
+        result all{0, 0}, any{0, 0};
+        for (int r = 0; r != repeats; ++r) {
+            const auto a = run([](auto& f) { return attach_when_all(f); }, inputs);
+            const auto b = run([](auto& f) { return attach_when_any(f); }, inputs);
+            if (r == 0 || a._inputs_per_second > all._inputs_per_second) all = a;
+            if (r == 0 || b._inputs_per_second > any._inputs_per_second) any = b;
+        }
+        std::cout << std::setw(10) << inputs << std::fixed << std::setprecision(1)
+                  << std::setw(22) << all._bytes_per_input << std::setprecision(2)
+                  << std::setw(12) << all._inputs_per_second / 1e6 << std::setprecision(1)
+                  << std::setw(22) << any._bytes_per_input << std::setprecision(2)
+                  << std::setw(12) << any._inputs_per_second / 1e6 << "\n";
+    }
+}